@@ -1,19 +1,17 @@
 #include "ai.h"
 
 #include "tetromino.h"
-#include "utils.h"
+#include "print_color.h"
+#include "planner.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <limits.h>
 
 
 /* AI Struct declaration */
-typedef struct SquarePos {
-    uint8_t x;
-    uint8_t y;
-} SquarePos;
-
 typedef struct MinMax {
     uint8_t min_x;
     uint8_t max_x;
@@ -22,34 +20,36 @@ typedef struct MinMax {
 } MinMax;
 
 
+/* The state shared by the tasks expanding the boards of a depth of the lookahead */
+typedef struct LookaheadBatch {
+    AI* ai;
+    const AIBeamNode* previous;                  // The boards of the previous depth
+    uint8_t size;                                // The number of boards of the previous depth
+    uint8_t depth;                               // The index of the tetromino placed
+    BlockType pieces[2][AI_MAX_BEAM_DEPTH];      // The block types placed, without and with the hold used first
+    uint16_t offsets[AI_MAX_BEAM_WIDTH + 1];     // The index of the first placement of each board in all the placements
+    uint8_t nb_tasks;                            // The number of tasks scoring the placements
+} LookaheadBatch;
+
+
 /* AI functions declaration */
-void calculate_best_path(AI* ai);
-void generate_path(AI* ai, uint8_t rotation, int8_t move_right_left);
-void set_position(Tetromino* tetromino, SquarePos** squares_pos);
-void set_left_position(Tetromino* tetromino, uint8_t** map);
-void set_max_position(Tetromino* tetromino, uint8_t** map);
-void rotate(Tetromino* tetromino);
-bool tetromino_left_blocked(Tetromino* tetromino, uint8_t** map);
+void update_path(AI* ai);
+void run_beam_tasks(AI* ai, PoolTask task, LookaheadBatch* batch, uint32_t nb_tasks);
+MoveSearch* get_beam_search(const LookaheadBatch* batch, uint8_t node);
+void search_beam_node(void* context, uint32_t task, uint8_t worker);
+void score_placements(void* context, uint32_t task, uint8_t worker);
+uint8_t merge_beam(AI* ai, const AIBeamNode* previous, uint8_t nb_tasks, AIBeamNode* beam);
+void insert_candidate(AIBeamCandidate* candidates, uint8_t* size, uint8_t max_size, const AIBeamCandidate* candidate);
+void generate_path(AI* ai, bool hold, const MoveSearch* search, uint16_t placement);
+bool follow_path(AI* ai);
 void process_action(Board* board, AIAction action);
+AIAction get_action_for_input(BoardInput input);
+bool same_position(const Tetromino* tetromino1, const Tetromino* tetromino2);
 
-int8_t calculate_path(Tetromino* tetromino, uint8_t** map, MinMax* min_max);
-uint8_t count_holes(uint8_t** map, MinMax* min_max, Tetromino* tetromino);
-uint8_t count_lines_destroyed(uint8_t** map);
-uint8_t get_avg_height(Tetromino* tetromino);
-
-int8_t get_moves_right_left(uint8_t rotation, Tetromino* tetromino, SquarePos** target_position);
-bool squares_pos_same_x(SquarePos** pos1, SquarePos** pos2, Tetromino* tetromino);
-void add_position(SquarePos** squares_pos, int8_t x, int8_t y, Tetromino* tetromino);
-uint8_t get_number_of_path(Tetromino* tetromino, uint8_t** map);
-MinMax* get_min_max(Tetromino* tetromino);
-void copy_tetromino_in_map(uint8_t** map, Tetromino* tetromino);
-uint8_t** get_copy_of_map(Board* board);
-Tetromino* get_copy_of_tetromino(Board* board);
-SquarePos** get_copy_of_squares_pos(Tetromino* tetromino);
-
-void clean_tetromino_from_map(uint8_t** map, Tetromino* tetromino);
-void clean_map(uint8_t** map);
-void clean_squares_pos(SquarePos** squares_pos, Tetromino* tetromino);
+MinMax get_min_max(Tetromino* tetromino);
+void copy_tetromino_in_map(Map* map, Tetromino* tetromino);
+
+void clean_tetromino_from_map(Map* map, Tetromino* tetromino);
 
 uint16_t get_time_to_update(AIDifficulty difficulty);
 
@@ -67,13 +67,24 @@ AI* create_ai(Board* board)
 	AI* ai = malloc(sizeof(AI));
 	if (ai == NULL)
 		return NULL;
+    ai->lookahead = malloc(AI_MAX_BEAM_WIDTH * sizeof(MoveSearch));
+    if (ai->lookahead == NULL)
+    {
+        free(ai);
+        return NULL;
+    }
 	ai->ai_board = board;
 	ai->actual_index = 0;
     ai->size_actions = 0;
-    ai->actions = NULL;
     ai->path_found = false;
     ai->time_update = 0;
     ai->time_to_update = 0;
+    ai->beam_width = AI_BEAM_WIDTH;
+    ai->beam_depth = AI_BEAM_DEPTH;
+    get_default_weights(&ai->weights);
+    ai->pool = NULL;
+    ai->planner = NULL;
+    ai->plan_requested = false;
 	return ai;
 }
 
@@ -86,10 +97,7 @@ AI* create_ai(Board* board)
 void clean_ai(AI** ai) 
 {
     AI* _ai = (*ai);
-    if (_ai->actions != NULL)
-    {
-        free(_ai->actions);
-    }
+    free(_ai->lookahead);
 	free(_ai);
 	*ai = NULL;
 }
@@ -102,12 +110,10 @@ void clean_ai(AI** ai)
 */
 void reset_ai(AI* ai)
 {
-    if (ai->actions != NULL)
-        free(ai->actions);
-    ai->actions = NULL;
     ai->size_actions = 0;
     ai->actual_index = 0;
     ai->path_found = false;
+    ai->plan_requested = false;
     ai->time_update = 0;
 }
 
@@ -133,460 +139,540 @@ void set_ai_difficulty(AI* ai, AIDifficulty difficulty)
 */
 void ai_process(AI* ai, double delta_t) 
 {
+    // Nothing to play when the board is full
+    if (ai->ai_board->full || ai->ai_board->actual_tetromino.block_type == B_NONE)
+        return;
+
     ai->time_update += delta_t;
 
-    if (!ai->path_found || ai->actual_index == ai->size_actions) 
-        calculate_best_path(ai);
+    // With a planner, nothing is played until its path is received
+    if (!ai->path_found)
+        update_path(ai);
+    if (!ai->path_found)
+        return;
 
     if (ai->time_update > ai->time_to_update)
     {
+        // The tetromino fell or changed since the path was found, the path is found again if it does not lead to the same place
+        if (!same_position(&ai->ai_board->actual_tetromino, &ai->expected[ai->actual_index]) && !follow_path(ai))
+        {
+            ai->path_found = false;
+            ai->plan_requested = false;
+            update_path(ai);
+            if (!ai->path_found)
+                return;
+        }
+
         process_action(ai->ai_board, ai->actions[ai->actual_index]);
         ai->actual_index++;
         ai->time_update = 0;
+
+        // The next tetromino needs a new path
+        if (ai->actual_index == ai->size_actions)
+        {
+            ai->path_found = false;
+            ai->plan_requested = false;
+        }
     }
 }
 
 
-/* #################### AI METHODS #################### */
-
 /**
- * Calculate the best path for the actual tetromino of the board.
+ * Set the lookahead of the AI, the number of boards kept and of tetrominos placed to choose a placement.
  * 
- * \param ai the AI concerned.
+ * \param ai the ai concerned.
+ * \param width the number of boards kept at each depth, between 1 and AI_MAX_BEAM_WIDTH.
+ * \param depth the number of tetrominos placed, between 1 (only the actual one) and AI_MAX_BEAM_DEPTH.
 */
-void calculate_best_path(AI* ai) 
+void set_ai_lookahead(AI* ai, uint8_t width, uint8_t depth)
 {
-    ai->actual_index = 0;
-    uint8_t** map_copy = get_copy_of_map(ai->ai_board);
-    Tetromino* tetromino_copy = get_copy_of_tetromino(ai->ai_board);
-    SquarePos** base_squares_pos = get_copy_of_squares_pos(tetromino_copy);
-    SquarePos** best_pos = NULL;
-
-    int8_t score = CHAR_MIN;
-    uint8_t number_of_rotations = get_number_of_rotation(tetromino_copy->block_type);
-    uint8_t best_rotation = 0;
-
-    // Foreach rotation of the tetromino
-    for (uint8_t rotation = 0; rotation < number_of_rotations; rotation++)
-    {
-        set_left_position(tetromino_copy, map_copy);
-        uint8_t number_of_path = get_number_of_path(tetromino_copy, map_copy);
-        SquarePos** start_position = get_copy_of_squares_pos(tetromino_copy);
-
-        // Foreach path for that rotation
-        for (uint8_t path = 0; path < number_of_path; path++) 
-        {
-            set_max_position(tetromino_copy, map_copy);
+    ai->beam_width = width < 1 ? 1 : width > AI_MAX_BEAM_WIDTH ? AI_MAX_BEAM_WIDTH : width;
+    ai->beam_depth = depth < 1 ? 1 : depth > AI_MAX_BEAM_DEPTH ? AI_MAX_BEAM_DEPTH : depth;
+}
 
-            MinMax* min_max = get_min_max(tetromino_copy);
-            if (min_max->min_y < 0)
-            {
-                free(min_max);
-                continue;
-            }
-            copy_tetromino_in_map(map_copy, tetromino_copy);
-            int8_t score_path = calculate_path(tetromino_copy, map_copy, min_max);
-            if (score_path > score)
-            {
-                score = score_path;
-                best_rotation = rotation;
-                if (best_pos != NULL)
-                    clean_squares_pos(best_pos, tetromino_copy);
-                best_pos = get_copy_of_squares_pos(tetromino_copy);
-            }
-            clean_tetromino_from_map(map_copy, tetromino_copy);
 
-            add_position(start_position, 1, 0, tetromino_copy);
-            set_position(tetromino_copy, start_position);
-            free(min_max);
-        }
-        rotate(tetromino_copy);
-        clean_squares_pos(start_position, tetromino_copy);
-    }
+/**
+ * Set the weights of the features used to score the boards of the lookahead.
+ * 
+ * \param ai the ai concerned.
+ * \param weights the weights of the features.
+*/
+void set_ai_weights(AI* ai, const AIWeights* weights)
+{
+    ai->weights = *weights;
+}
 
-    set_position(tetromino_copy, base_squares_pos);
-    tetromino_copy->rotation = 0;
-    
-    if (best_pos != NULL)
-    {
-        int8_t moves_right_left = get_moves_right_left(best_rotation, tetromino_copy, best_pos);
-        generate_path(ai, best_rotation, moves_right_left);
-    }
 
-    clean_squares_pos(base_squares_pos, tetromino_copy);
-    clean_map(map_copy);
-    clean_tetromino(&tetromino_copy);
-    ai->path_found = true;
+/**
+ * Set the thread pool searching and scoring the placements of the lookahead, the path found stays the same.
+ * The pool is not owned by the AI, it must be cleaned after the AI.
+ * 
+ * \param ai the ai concerned.
+ * \param pool the thread pool, NULL to use the calling thread.
+*/
+void set_ai_thread_pool(AI* ai, ThreadPool* pool)
+{
+    ai->pool = pool;
 }
 
 
 /**
- * Generate the path for the ai which will be store in actions of ai.
+ * Set the planner searching the paths of the AI in the background, the frames then never wait for a search.
+ * The planner is not owned by the AI, it must be cleaned after the AI.
  * 
  * \param ai the ai concerned.
- * \param rotation the index of the rotation of the tetromino.
- * \param move_right_left the amount of MOVE_RIGHT or MOVE_LEFT.
+ * \param planner the planner, NULL to search the paths in ai_process.
 */
-void generate_path(AI* ai, uint8_t rotation, int8_t move_right_left) 
+void set_ai_planner(AI* ai, struct AIPlanner* planner)
 {
-    if (ai->actions != NULL)
-        free(ai->actions);
+    ai->planner = planner;
+    reset_ai(ai);
+}
 
-    uint8_t number_of_actions = rotation + abs(move_right_left) + 1;
-    ai->actions = malloc(sizeof(AIAction) * (number_of_actions));
-    ai->size_actions = number_of_actions;
 
-    uint8_t index = 0;
-    for (uint8_t i = 0; i < rotation; i++) 
+/* #################### AI METHODS #################### */
+
+/**
+ * Find a new path for the actual tetromino, or ask it to the planner and take it once it is ready.
+ * 
+ * \param ai the AI concerned.
+*/
+void update_path(AI* ai)
+{
+    if (ai->planner == NULL)
     {
-        ai->actions[index] = ROTATE;
-        index++;
+        calculate_best_path(ai);
+        return;
     }
 
-    for (uint8_t i = 0; i < abs(move_right_left); i++) 
+    if (!ai->plan_requested)
     {
-        ai->actions[index] = move_right_left < 0 ? MOVE_LEFT : MOVE_RIGHT;
-        index++;
+        request_ai_plan(ai->planner, ai);
+        ai->plan_requested = true;
     }
-
-    ai->actions[ai->size_actions - 1] = HARD_DROP;
+    AIPlan plan;
+    if (!take_ai_plan(ai->planner, &plan))
+        return;
+    memcpy(ai->actions, plan.actions, plan.size_actions * sizeof(AIAction));
+    memcpy(ai->expected, plan.expected, plan.size_actions * sizeof(Tetromino));
+    ai->target = plan.target;
+    ai->size_actions = plan.size_actions;
+    ai->actual_index = 0;
+    ai->plan_requested = false;
+    ai->path_found = true;
 }
 
 
 /**
- * Set the tetromino position to the first possible position in the map on the left.
+ * Calculate the best path for the actual tetromino of the board, from its actual position.
+ * The placements are chosen with a beam search over the next tetrominos : at each depth,
+ * only the best boards are kept and the next tetromino is placed on each of them.
+ * With a thread pool, the boards of a depth are searched in parallel, then all their placements
+ * are split in tasks of about the same size to be scored. The best candidates of the tasks are merged
+ * in the order of the placements, so the path is the same with any number of threads.
+ * The tetromino it would get from the hold is also tried first.
  * 
- * \param tetromino the tetromino which will be set to the first position.
- * \param map the map of the board.
+ * \param ai the AI concerned.
 */
-void set_left_position(Tetromino* tetromino, uint8_t** map)
+void calculate_best_path(AI* ai) 
 {
-    bool blocked = tetromino_left_blocked(tetromino, map);
-    while (!blocked) 
+    ai->actual_index = 0;
+    const Board* board = ai->ai_board;
+
+    // The block types placed, without and with the hold used first
+    LookaheadBatch batch;
+    batch.ai = ai;
+    batch.pieces[0][0] = board->actual_tetromino.block_type;
+    batch.pieces[1][0] = board->hold != B_NONE ? board->hold : get_next_block_type(board, 0);
+    for (uint8_t i = 1; i < AI_MAX_BEAM_DEPTH; i++)
+    {
+        batch.pieces[0][i] = get_next_block_type(board, i - 1);
+        batch.pieces[1][i] = get_next_block_type(board, board->hold != B_NONE ? i - 1 : i);
+    }
+
+    // The first depth starts from the board, the board of the hold comes after to keep the actual tetromino on ties
+    uint8_t size = board->hold_used ? 1 : 2;
+    AIBeamNode* beam = ai->beam[1];
+    for (uint8_t i = 0; i < size; i++)
     {
-        for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-            tetromino->squares[i]->x--;
-        blocked = tetromino_left_blocked(tetromino, map);
+        beam[i].map = board->map;
+        memcpy(beam[i].heights, board->heights, MAP_WIDTH);
+        beam[i].score = 0;
+        beam[i].lines = 0;
+        beam[i].first = -1;
+        beam[i].hold = i == 1;
+        beam[i].first_min_x = 0;
     }
+
+    for (uint8_t depth = 0; depth < ai->beam_depth; depth++)
+    {
+        batch.previous = beam;
+        batch.size = size;
+        batch.depth = depth;
+        run_beam_tasks(ai, &search_beam_node, &batch, size);
+
+        // The placements of all the boards follow each other, each task scores a contiguous part of them.
+        // Without pool, a single task avoids merging more candidates
+        batch.offsets[0] = 0;
+        for (uint8_t i = 0; i < size; i++)
+            batch.offsets[i + 1] = batch.offsets[i] + get_beam_search(&batch, i)->nb_placements;
+        const uint16_t max_tasks = ai->pool != NULL ? AI_MAX_BEAM_TASKS : 1;
+        const uint16_t nb_tasks = (batch.offsets[size] + AI_TASK_PLACEMENTS - 1) / AI_TASK_PLACEMENTS;
+        batch.nb_tasks = nb_tasks < 1 ? 1 : nb_tasks > max_tasks ? max_tasks : nb_tasks;
+        run_beam_tasks(ai, &score_placements, &batch, batch.nb_tasks);
+
+        // Every board is lost at this depth, the best one of the previous depth is played
+        uint8_t next_size = merge_beam(ai, beam, batch.nb_tasks, ai->beam[depth % 2]);
+        if (next_size == 0)
+            break;
+        beam = ai->beam[depth % 2];
+        size = next_size;
+    }
+
+    if (beam[0].first < 0)
+        generate_path(ai, false, &ai->search, -1);
+    else
+        generate_path(ai, beam[0].hold, beam[0].hold ? &ai->hold_search : &ai->search, beam[0].first);
+    ai->path_found = true;
 }
 
 
 /**
- * Set the max position in depth for that tetromino.
+ * Run tasks of a depth of the lookahead on the thread pool of the AI, or on the calling thread without pool.
  * 
- * \param tetromino the tetromino to be set to the max position.
- * \param map the map associated with the board.
+ * \param ai the AI concerned.
+ * \param task the function run for each task.
+ * \param batch the lookahead batch given to the tasks.
+ * \param nb_tasks the number of tasks.
 */
-void set_max_position(Tetromino* tetromino, uint8_t** map) 
+void run_beam_tasks(AI* ai, PoolTask task, LookaheadBatch* batch, uint32_t nb_tasks)
 {
-    bool blocked = tetromino_blocked(map, tetromino);
-    while (!blocked)
-    {
-        for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-            tetromino->squares[i]->y++;
-        blocked = tetromino_blocked(map, tetromino);
-    }
+    if (ai->pool != NULL)
+        run_thread_pool(ai->pool, task, batch, nb_tasks);
+    else
+        for (uint32_t i = 0; i < nb_tasks; i++)
+            task(batch, i, 0);
 }
 
 
 /**
- * Set the tetromino position to the squares pos.
+ * Get the search of the placements on a board of the previous depth.
+ * The searches of the first depth are kept in the AI to generate the path.
  * 
- * \param tetromino the tetromino to be changed.
- * \param squares_pos all the squares pos.
+ * \param batch the lookahead batch.
+ * \param node the index of the board in the previous depth.
+ * \return the search of the board.
 */
-void set_position(Tetromino* tetromino, SquarePos** squares_pos) 
+MoveSearch* get_beam_search(const LookaheadBatch* batch, uint8_t node)
 {
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++) 
-    {
-        SquarePos* square_pos = squares_pos[i];
-        Square* square = tetromino->squares[i];
-        square->x = square_pos->x;
-        square->y = square_pos->y;
-    }
+    AI* ai = batch->ai;
+    if (batch->depth == 0)
+        return batch->previous[node].hold ? &ai->hold_search : &ai->search;
+    return &ai->lookahead[node];
 }
 
 
 /**
- * Check if a tetromino is left blocked.
+ * Search the placements of the next tetromino on a board of the lookahead.
+ * It is a task of the thread pool, it only writes the search of its board.
  * 
- * \param tetromino the tetromino to be checked.
- * \param map the map of the board.
- * \return true if the tetromino is left blocked, false else.
+ * \param context the lookahead batch.
+ * \param task the index of the board in the previous depth.
+ * \param worker the index of the worker running the task, unused.
 */
-bool tetromino_left_blocked(Tetromino* tetromino, uint8_t** map) 
+void search_beam_node(void* context, uint32_t task, uint8_t worker)
 {
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++) 
-    {
-        Square* square = tetromino->squares[i];
-
-        if (square->x == 0)
-            return true;
-
-        if (square->y >= 0 && map[square->y][square->x - 1])
-        {
-            if (square_in_tetromino(tetromino, square->x - 1, square->y))
-                continue;
-            else
-                return true;
-        }
-    }
-    return false;
+    (void) worker;
+    const LookaheadBatch* batch = context;
+    const AIBeamNode* parent = &batch->previous[task];
+    Tetromino start = spawn_tetromino(batch->pieces[parent->hold][batch->depth]);
+    if (batch->depth == 0 && !parent->hold)
+        start = batch->ai->ai_board->actual_tetromino;
+    search_moves(get_beam_search(batch, task), &parent->map, parent->heights, &start);
 }
 
 
 /**
- * Check if a tetromino is right blocked.
- *
- * \param tetromino the tetromino to be checked.
- * \param map the map of the board.
- * \return true if the tetromino is right blocked, false else.
+ * Score a contiguous part of the placements found on the boards of the lookahead and keep the best ones.
+ * It is a task of the thread pool, it only writes its own candidates.
+ * 
+ * \param context the lookahead batch, with the searches of its boards done.
+ * \param task the index of the task, the tasks split the placements in the order of the boards.
+ * \param worker the index of the worker running the task, unused.
 */
-bool tetromino_right_blocked(Tetromino* tetromino, uint8_t** map) 
+void score_placements(void* context, uint32_t task, uint8_t worker)
 {
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
+    (void) worker;
+    const LookaheadBatch* batch = context;
+    AI* ai = batch->ai;
+    const uint16_t nb_placements = batch->offsets[batch->size];
+    const uint16_t begin = (uint32_t) nb_placements * task / batch->nb_tasks;
+    const uint16_t end = (uint32_t) nb_placements * (task + 1) / batch->nb_tasks;
+
+    AIBeamCandidate* candidates = ai->candidates[task];
+    uint8_t size = 0;
+    for (uint8_t node = 0; node < batch->size; node++)
     {
-        Square* square = tetromino->squares[i];
-
-        if (square->x == MAP_WIDTH - 1)
-            return true;
+        // The placements of this board scored by the task
+        if (batch->offsets[node + 1] <= begin || batch->offsets[node] >= end)
+            continue;
+        const uint16_t first = begin > batch->offsets[node] ? begin - batch->offsets[node] : 0;
+        const uint16_t last = (end < batch->offsets[node + 1] ? end : batch->offsets[node + 1]) - batch->offsets[node];
 
-        if (square->y >= 0 && map[square->y][square->x + 1])
+        const AIBeamNode* parent = &batch->previous[node];
+        const MoveSearch* search = get_beam_search(batch, node);
+        Map map = parent->map;
+        for (uint16_t i = first; i < last; i++)
         {
-            if (square_in_tetromino(tetromino, square->x + 1, square->y))
+            AIBeamCandidate candidate;
+            candidate.tetromino = search->placements[i].tetromino;
+
+            // Above the map, the placement is not possible
+            MinMax min_max = get_min_max(&candidate.tetromino);
+            if (min_max.min_y < 0)
                 continue;
-            else
-                return true;
+
+            // The lines cleared count for the whole sequence, the other features only for the last board
+            uint16_t cleared[MAP_HEIGHT];
+            int16_t features[NB_FEATURES];
+            copy_tetromino_in_map(&map, &candidate.tetromino);
+            const uint8_t lines = remove_full_rows(map.rows, cleared);
+            clean_tetromino_from_map(&map, &candidate.tetromino);
+            get_board_features(cleared, features);
+            candidate.lines = parent->lines + lines;
+            features[FEATURE_LINES] = candidate.lines;
+            candidate.score = evaluate_features(&ai->weights, features);
+            candidate.first = parent->first < 0 ? (int16_t) i : parent->first;
+            candidate.first_min_x = parent->first < 0 ? min_max.min_x : parent->first_min_x;
+            candidate.parent = node;
+            insert_candidate(candidates, &size, ai->beam_width, &candidate);
         }
     }
-    return false;
+    ai->nb_candidates[task] = size;
 }
 
 
 /**
- * Rotate the tetromino.
- * Assume that we can rotate it.
+ * Merge the candidates of the tasks of a depth in their order and build the boards of the next depth.
  * 
- * \param tetromino the tetromino to be rotated.
+ * \param ai the AI concerned.
+ * \param previous the boards of the previous depth.
+ * \param nb_tasks the number of tasks which scored the placements.
+ * \param beam the boards of the next depth.
+ * \return the number of boards of the next depth.
 */
-void rotate(Tetromino* tetromino) 
+uint8_t merge_beam(AI* ai, const AIBeamNode* previous, uint8_t nb_tasks, AIBeamNode* beam)
 {
-    int8_t** moves = get_next_rotation_moves(tetromino);
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
+    AIBeamCandidate best[AI_MAX_BEAM_WIDTH];
+    uint8_t size = 0;
+    for (uint8_t i = 0; i < nb_tasks; i++)
+        for (uint8_t j = 0; j < ai->nb_candidates[i]; j++)
+            insert_candidate(best, &size, ai->beam_width, &ai->candidates[i][j]);
+
+    for (uint8_t i = 0; i < size; i++)
     {
-        tetromino->squares[i]->x += moves[i][0];
-        tetromino->squares[i]->y += moves[i][1];
+        AIBeamNode* node = &beam[i];
+        const AIBeamNode* parent = &previous[best[i].parent];
+        node->map = parent->map;
+        copy_tetromino_in_map(&node->map, &best[i].tetromino);
+        remove_full_rows(node->map.rows, node->map.rows);
+        get_map_heights(&node->map, node->heights);
+        node->score = best[i].score;
+        node->lines = best[i].lines;
+        node->first = best[i].first;
+        node->hold = parent->hold;
+        node->first_min_x = best[i].first_min_x;
     }
-    update_rotation(tetromino);
-
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-        free(moves[i]);
-    free(moves);
+    return size;
 }
 
 
 /**
- * Calculate the score of the actual path.
+ * Insert a candidate in a list sorted from the best, after the candidates which are as good.
+ * Between candidates of the same score, the one whose first placement is the leftmost is better
+ * so the stack is built from the left.
  * 
- * \param tetromino the tetromino which is placed in the map.
- * \param map the map associated with the board.
- * \param min_max the min and max for the tetromino.
- * \return the score for that path.
+ * \param candidates the sorted candidates.
+ * \param size the number of candidates.
+ * \param max_size the number of candidates kept.
+ * \param candidate the candidate inserted, ignored if it is not good enough.
 */
-int8_t calculate_path(Tetromino* tetromino, uint8_t** map, MinMax* min_max) 
+void insert_candidate(AIBeamCandidate* candidates, uint8_t* size, uint8_t max_size, const AIBeamCandidate* candidate)
 {
-    int8_t score = 0;
-    uint8_t number_of_holes = count_holes(map, min_max, tetromino);
-    uint8_t number_of_lines = count_lines_destroyed(map);
-    uint8_t avg_max_height = get_avg_height(tetromino);
-    score += avg_max_height;        // High height = more score
-    score += number_of_lines * 2;   // Lines destroyed = more score
-    score -= (number_of_holes * 3); // Less holes = more score
-    return score;
+    uint8_t position = *size;
+    while (position > 0 && (candidate->score > candidates[position - 1].score
+        || (candidate->score == candidates[position - 1].score
+        && candidate->first_min_x < candidates[position - 1].first_min_x)))
+        position--;
+    if (position >= max_size)
+        return;
+
+    if (*size < max_size)
+        (*size)++;
+    memmove(candidates + position + 1, candidates + position, (*size - 1 - position) * sizeof(AIBeamCandidate));
+    candidates[position] = *candidate;
 }
 
 
 /**
- * Count the number of holes below the tetromino.
- * WARNING : The tetromino has to be in the map.
- *
- * \param map the associated map of the board.
- * \param min_max the min max object of the tetromino.
- * \param tetromino the tetromino associated.
- * \return the number of holes below the tetromino.
+ * Generate the path for the ai which will be store in actions of ai.
+ * The tetromino expected before each action is kept to check the path is still right.
+ * 
+ * \param ai the ai concerned.
+ * \param hold if the tetromino must be held first.
+ * \param search the search of the placement, started from the tetromino played.
+ * \param placement the index of the placement in the search, -1 to only drop the actual tetromino.
 */
-uint8_t count_holes(uint8_t** map, MinMax* min_max, Tetromino* tetromino)
+void generate_path(AI* ai, bool hold, const MoveSearch* search, uint16_t placement) 
 {
-    uint8_t count = 0;
-
-    for (uint8_t x = min_max->min_x; x <= min_max->max_x; x++) 
+    uint8_t index = 0;
+    if (hold)
     {
-        uint8_t y = min_max->min_y;
+        ai->actions[index] = HOLD;
+        ai->expected[index] = ai->ai_board->actual_tetromino;
+        index++;
+    }
 
-        // Go to the nearest square in tetromino
-        if (map[y][x] == 0)
-        {
-            while (!square_in_tetromino(tetromino, x, y))
-                y++;
-        }
-        
-        // Go below the square
-        while (y < MAP_HEIGHT && square_in_tetromino(tetromino, x, y))
-            y++;
-        
-        // Count the hole while there is another square
-        while (y < MAP_HEIGHT && !map[y][x])
-        {
-            y++;
-            count++;
-        }
+    if (placement == (uint16_t) -1)
+    {
+        ai->actions[index] = HARD_DROP;
+        ai->expected[index] = ai->ai_board->actual_tetromino;
+        ai->target.block_type = B_NONE;
+        ai->size_actions = index + 1;
+        return;
     }
 
-    return count;
+    BoardInput path[MAX_PATH_LENGTH];
+    uint8_t length = get_placement_path(search, placement, path, ai->expected + index);
+    for (uint8_t i = 0; i < length; i++)
+        ai->actions[index + i] = get_action_for_input(path[i]);
+    ai->target = search->placements[placement].tetromino;
+    ai->size_actions = index + length;
 }
 
 
 /**
- * Count the number of lines which will be destroyed.
+ * Check if the rest of the path still leads to its final position from the actual tetromino,
+ * usually when the gravity made it fall, and update the tetrominos expected if it does.
+ * The soft drops which are not possible anymore are ignored, like the board does.
  * 
- * \param map the map associated with the board.
- * \return the number of lines which will be destroyed.
+ * \param ai the AI concerned.
+ * \return false if the path must be found again.
 */
-uint8_t count_lines_destroyed(uint8_t** map)
+bool follow_path(AI* ai)
 {
-    uint8_t count = 0;
-    for (uint8_t y = 0; y < MAP_HEIGHT; y++) 
+    const Board* board = ai->ai_board;
+    Tetromino tetromino = board->actual_tetromino;
+    if (ai->target.block_type != tetromino.block_type)
+        return false;
+
+    for (uint8_t i = ai->actual_index; i < ai->size_actions; i++)
     {
-        uint8_t temp = 0;
-        for (uint8_t x = 0; x < MAP_WIDTH; x++)
+        ai->expected[i] = tetromino;
+        switch (ai->actions[i])
         {
-            if (map[y][x])
-                temp++;
+            case HARD_DROP:
+                tetromino.y += drop_distance(&board->map, board->heights, &tetromino);
+                return same_position(&tetromino, &ai->target);
+            case SOFT_DROP:
+                move_by_input(&board->map, &tetromino, INPUT_SOFT_DROP);
+                break;
+            case MOVE_LEFT:
+            case MOVE_RIGHT:
+            case ROTATE:
+            {
+                const BoardInput input = ai->actions[i] == ROTATE ? INPUT_ROTATE
+                    : ai->actions[i] == MOVE_LEFT ? INPUT_LEFT : INPUT_RIGHT;
+                if (!move_by_input(&board->map, &tetromino, input))
+                    return false;
+                break;
+            }
+            default:
+                return false;
         }
-        if (temp == MAP_WIDTH)
-            count++;
     }
-    return count;
-}
-
-
-/**
- * Get the average height of each square in the tetromino.
- * 
- * \param tetromino the tetromino to be examined.
- * \return the average height.
-*/
-uint8_t get_avg_height(Tetromino* tetromino) 
-{
-    uint8_t total = 0;
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-        total += tetromino->squares[i]->y;
-    return round((float)total / (float)tetromino->nb_squares);
+    return false;
 }
 
 
 /**
  * Process the action for the board.
- * Simulate a keyboard event.
+ * Simulate a player input.
  * 
- * \param board the board receiving an keyboard event.
+ * \param board the board receiving an input.
  * \param action the action to process to the board.
 */
 void process_action(Board* board, AIAction action) 
 {
-    SDL_Keycode key;
+    BoardInput input = INPUT_NONE;
     switch (action) 
     {
         case ROTATE:
-            key = SDLK_r;
+            input = INPUT_ROTATE;
             break;
         case HARD_DROP:
-            key = SDLK_SPACE;
+            input = INPUT_HARD_DROP;
             break;
         case MOVE_LEFT:
-            key = SDLK_q;
+            input = INPUT_LEFT;
             break;
         case MOVE_RIGHT:
-            key = SDLK_d;
+            input = INPUT_RIGHT;
+            break;
+        case HOLD:
+            input = INPUT_HOLD;
+            break;
+        case SOFT_DROP:
+            input = INPUT_SOFT_DROP;
             break;
         case NONE:
         default:
             break;
     }
-    keyboard_event(board, key);
-}
-
-
-/**
- * Return the movement to do left or right for the tetromino.
- * WARNING : the tetromino has to be in the initial state and position.
- * 
- * \param rotation the rotation of the tetromino.
- * \param tetromino the tetromino concerned.
- * \param position the position of the tetromino.
- * \return the amount to add to x to get to the target position (can be negative).
-*/
-int8_t get_moves_right_left(uint8_t rotation, Tetromino* tetromino, SquarePos** target_position) 
-{
-    int8_t moves = 0;
-    for (uint8_t i = 0; i < rotation; i++)
-        rotate(tetromino);
-    
-    SquarePos** squares_pos = get_copy_of_squares_pos(tetromino);
-
-    int8_t x_amount = squares_pos[0]->x < target_position[0]->x ? 1 : -1;
-    while (!squares_pos_same_x(squares_pos, target_position, tetromino))
-    {    
-        add_position(squares_pos, x_amount, 0, tetromino);
-        moves += x_amount;
-    }
-    clean_squares_pos(squares_pos, tetromino);
-    return moves;
+    board_input(board, input);
 }
 
 
 /**
- * Add an x and y amount to all the squares positions.
+ * Get the action of the AI giving an input to the board.
  * 
- * \param squares_pos the array of square pos.
- * \param x the amount to be added to x of all squares pos.
- * \param y the amount to be added to y of all squares pos.
- * \param tetromino the tetromino associated with the square pos.
+ * \param input the input of the board.
+ * \return the action giving this input.
 */
-void add_position(SquarePos** squares_pos, int8_t x, int8_t y, Tetromino* tetromino) 
+AIAction get_action_for_input(BoardInput input)
 {
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++) 
+    switch (input)
     {
-        SquarePos* square_pos = squares_pos[i];
-        square_pos->x += x;
-        square_pos->y += y;
+        case INPUT_ROTATE:
+            return ROTATE;
+        case INPUT_HARD_DROP:
+            return HARD_DROP;
+        case INPUT_LEFT:
+            return MOVE_LEFT;
+        case INPUT_RIGHT:
+            return MOVE_RIGHT;
+        case INPUT_SOFT_DROP:
+            return SOFT_DROP;
+        case INPUT_HOLD:
+            return HOLD;
+        case INPUT_NONE:
+        default:
+            return NONE;
     }
 }
 
 
 /**
- * Get the number of path possible.
- * WARNING : tetromino has to be on the max left position.
+ * Check if two tetrominos are the same piece at the same position, blocked or not.
  * 
- * \param tetromino the tetromino to count the path possible.
- * \param map the map associated with the board.
- * \return the number of path possible.
+ * \param tetromino1 the first tetromino.
+ * \param tetromino2 the second tetromino.
+ * \return true if they are at the same position.
 */
-uint8_t get_number_of_path(Tetromino* tetromino, uint8_t** map) 
+bool same_position(const Tetromino* tetromino1, const Tetromino* tetromino2)
 {
-    SquarePos** base_pos = get_copy_of_squares_pos(tetromino);
-    uint8_t count = 1;
-    bool blocked = tetromino_right_blocked(tetromino, map);
-    while (!blocked)
-    {
-        for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-            tetromino->squares[i]->x++;
-        count++;
-        blocked = tetromino_right_blocked(tetromino, map);
-    }
-    set_position(tetromino, base_pos);
-    clean_squares_pos(base_pos, tetromino);
-    return count;
+    return tetromino1->block_type == tetromino2->block_type && tetromino1->rotation == tetromino2->rotation
+        && tetromino1->x == tetromino2->x && tetromino1->y == tetromino2->y;
 }
 
 
@@ -597,13 +683,13 @@ uint8_t get_number_of_path(Tetromino* tetromino, uint8_t** map)
  * \param map the map which will contain the tetromino.
  * \param tetromino the tetromino to copied inside the map.
 */
-void copy_tetromino_in_map(uint8_t** map, Tetromino* tetromino) 
+void copy_tetromino_in_map(Map* map, Tetromino* tetromino) 
 {
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++) 
+    for(uint8_t i = 0; i < NB_SQUARES; i++) 
     {
-        Square* square = tetromino->squares[i];
-        if (square->y > 0)
-            map[square->y][square->x] = tetromino->color;
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.y >= 0)
+            map->rows[square.y] |= 1 << square.x;
     }
 }
 
@@ -615,160 +701,52 @@ void copy_tetromino_in_map(uint8_t** map, Tetromino* tetromino)
  * \param map the map to process.
  * \param tetromino the tetromino to remove from the map.
 */
-void clean_tetromino_from_map(uint8_t** map, Tetromino* tetromino)
+void clean_tetromino_from_map(Map* map, Tetromino* tetromino)
 {
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        Square* square = tetromino->squares[i];
-        if (square->y > 0)
-            map[square->y][square->x] = 0;
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.y >= 0)
+            map->rows[square.y] &= ~(1 << square.x);
     }
 }
 
 
-/**
- * Check if all the squares from pos1 have the same x with pos2.
- * 
- * \param pos1 the first position to be compared.
- * \param pos2 the second position to be compared.
- * \param tetromino the tetromino associated with the positions.
- * \return true if the squares have the same x, false else.
-*/
-bool squares_pos_same_x(SquarePos** pos1, SquarePos** pos2, Tetromino* tetromino)
-{
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++) 
-        if (pos1[i]->x != pos2[i]->x)
-            return false;
-    return true;
-}
-
-
 /**
  * Get the max min object from the tetromino
  * 
  * \param tetromino the tetromino containing all its squares.
  * \return the min max object.
 */
-MinMax* get_min_max(Tetromino* tetromino)
+MinMax get_min_max(Tetromino* tetromino)
 {
-    MinMax* min_max = malloc(sizeof(MinMax));
+    MinMax min_max;
     uint8_t max_x = 0;
     int8_t max_y = CHAR_MIN;
     uint8_t min_x = UCHAR_MAX;
     int8_t min_y = CHAR_MAX;
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        Square* square = tetromino->squares[i];
+        Square square = get_tetromino_square(tetromino, i);
 
-        if (square->x > max_x)
-            max_x = square->x;
-        if (square->x < min_x)
-            min_x = square->x;
+        if (square.x > max_x)
+            max_x = square.x;
+        if (square.x < min_x)
+            min_x = square.x;
 
-        if (square->y > max_y)
-            max_y = square->y;
-        if (square->y < min_y)
-            min_y = square->y;
+        if (square.y > max_y)
+            max_y = square.y;
+        if (square.y < min_y)
+            min_y = square.y;
     }
-    min_max->min_x = min_x;
-    min_max->min_y = min_y;
-    min_max->max_y = max_y;
-    min_max->max_x = max_x;
+    min_max.min_x = min_x;
+    min_max.min_y = min_y;
+    min_max.max_y = max_y;
+    min_max.max_x = max_x;
     return min_max;
 }
 
 
-/* #################### COPY METHODS #################### */
-
-/**
- * Copy the board map to a new one, without the actual tetromino.
- * 
- * \param board the board containing the map.
- * \return the map of the board copied.
-*/
-uint8_t** get_copy_of_map(Board* board) 
-{
-    uint8_t** map = malloc(sizeof(uint8_t*) * MAP_HEIGHT);
-    for (uint8_t i = 0; i < MAP_HEIGHT; i++) 
-        map[i] = malloc(sizeof(uint8_t) * MAP_WIDTH);
-
-    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
-        for (uint8_t j = 0; j < MAP_WIDTH; j++)
-            map[i][j] = board->map[i][j];
-
-    Tetromino* tetromino = board->actual_tetromino;
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-    {
-        Square* square = tetromino->squares[i];
-        if (square->y < 0)
-            continue;
-        map[square->y][square->x] = 0;
-    }
-
-    return map;
-}
-
-
-/**
- * Copy the actual tetromino of the board.
- * 
- * \param board the board containing the actual tetromino.
- * \return the tetromino copied from the board.
-*/
-Tetromino* get_copy_of_tetromino(Board* board) 
-{
-    Tetromino* tetromino = create_tetromino(board->actual_tetromino->block_type);
-    return tetromino;
-}
-
-
-/**
- * Copy the position of the tetromino into a array of SquarePos.
- * 
- * \param tetromino the tetromino to copy its position.
- * \return an array of SquarePos object containing the positions.
-*/
-SquarePos** get_copy_of_squares_pos(Tetromino* tetromino)
-{
-    SquarePos** squares_pos = malloc(sizeof(SquarePos*) * (tetromino->nb_squares));
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++) 
-    {
-        squares_pos[i] = malloc(sizeof(SquarePos));
-        squares_pos[i]->x = tetromino->squares[i]->x;
-        squares_pos[i]->y = tetromino->squares[i]->y;
-    }
-    return squares_pos;
-}
-
-
-/* #################### CLEAN METHODS #################### */
-
-/**
- * Correctly clean a map of a board.
- * 
- * \param map the map to be cleaned.
-*/
-void clean_map(uint8_t** map) 
-{
-    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
-        free(map[i]);
-    free(map);
-}
-
-
-/**
- * Correctly clean a SquarePos array.
- * 
- * \param squares_pos the array to be cleaned.
-*/
-void clean_squares_pos(SquarePos** squares_pos, Tetromino* tetromino)
-{
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-        free(squares_pos[i]);
-    free(squares_pos);
-}
-
-
 /* #################### UTILS METHODS #################### */
 
 /**
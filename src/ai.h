@@ -2,8 +2,10 @@
 #define AI_H
 
 #include "board.h"
+#include "moves.h"
+#include "thread_pool.h"
+#include "evaluator.h"
 
-#include <SDL2/SDL.h>
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -11,6 +13,13 @@
 #define TIME_MEDIUM 400
 #define TIME_HARD 200
 #define TIME_EXTREME 100
+#define AI_MAX_ACTIONS (MAX_PATH_LENGTH + 1) // The maximum number of actions of a path, with the hold
+#define AI_BEAM_WIDTH 8             // The default number of boards kept at each depth of the lookahead
+#define AI_BEAM_DEPTH 3             // The default number of tetrominos placed by the lookahead, the actual one included
+#define AI_MAX_BEAM_WIDTH 32
+#define AI_MAX_BEAM_DEPTH QUEUE_SIZE // The tetrominos known, even when the next one goes to the empty hold
+#define AI_MAX_BEAM_TASKS 64        // The most tasks scoring the placements of a depth, their candidates are merged
+#define AI_TASK_PLACEMENTS 8        // The fewest placements scored by a task, smaller tasks cost more than they save
 
 typedef enum AIDifficulty {
     EASY,
@@ -24,13 +33,50 @@ typedef enum AIAction {
     HARD_DROP,
     ROTATE,
     MOVE_RIGHT,
-    MOVE_LEFT
+    MOVE_LEFT,
+    HOLD,
+    SOFT_DROP
 } AIAction;
 
+/* A board of the lookahead, after some tetrominos were placed from the actual one. */
+typedef struct AIBeamNode {
+    Map map;                    // The map with the tetrominos placed and the full lines removed, without colors
+    uint8_t heights[MAP_WIDTH]; // The height of each column of the map
+    float score;                // The score of the lines cleared by the sequence and of the features of the map
+    uint8_t lines;              // The lines cleared by the sequence
+    int16_t first;              // The index of the first placement in its search
+    bool hold;                  // If the first tetromino placed comes from the hold
+    uint8_t first_min_x;        // The leftmost column of the first placement, to break the ties
+} AIBeamNode;
+
+/* A placement on a board of the lookahead, kept if it is among the best ones of its depth. */
+typedef struct AIBeamCandidate {
+    Tetromino tetromino;        // The tetromino placed
+    float score;                // The score of the board after the placement
+    uint8_t lines;              // The lines cleared by the sequence, this placement included
+    int16_t first;              // The index of the first placement in its search
+    uint8_t first_min_x;        // The leftmost column of the first placement
+    uint8_t parent;             // The index of the board where the tetromino is placed
+} AIBeamCandidate;
+
 typedef struct AI {
 	Board* ai_board;            // The board associated with the AI
     bool path_found;            // If there is a path found for the tetromino
-    AIAction* actions;          // The array of actions
+    AIAction actions[AI_MAX_ACTIONS]; // The actions of the path, no memory is allocated while playing
+    Tetromino expected[AI_MAX_ACTIONS]; // The tetromino expected before each action of the path
+    Tetromino target;           // The final position of the tetromino played by the path, B_NONE if it is unknown
+    MoveSearch search;          // The search of the placements of the actual tetromino
+    MoveSearch hold_search;     // The search of the placements of the tetromino from the hold
+    MoveSearch* lookahead;      // The search of the placements of the next tetrominos, one for each board of a depth
+    AIBeamNode beam[2][AI_MAX_BEAM_WIDTH]; // The boards kept at the previous and at the actual depth
+    AIBeamCandidate candidates[AI_MAX_BEAM_TASKS][AI_MAX_BEAM_WIDTH]; // The best placements of each task of a depth
+    uint8_t nb_candidates[AI_MAX_BEAM_TASKS];
+    ThreadPool* pool;           // The workers searching and scoring the placements, NULL to use the calling thread
+    struct AIPlanner* planner;  // The thread searching the paths, NULL to search them in ai_process
+    bool plan_requested;        // If a path was asked to the planner and not received yet
+    uint8_t beam_width;         // The number of boards kept at each depth
+    uint8_t beam_depth;         // The number of tetrominos placed, 1 to only look at the actual one
+    AIWeights weights;          // The weights of the features scoring the boards
     uint8_t actual_index;       // The actual index for the actions
     uint8_t size_actions;       // The size of the actions
     double time_update;         // The counter time for update
@@ -42,6 +88,11 @@ AI* create_ai(Board* board);
 void clean_ai(AI** ai);
 void reset_ai(AI* ai);
 void set_ai_difficulty(AI* ai, AIDifficulty difficulty);
+void set_ai_lookahead(AI* ai, uint8_t width, uint8_t depth);
+void set_ai_weights(AI* ai, const AIWeights* weights);
+void set_ai_thread_pool(AI* ai, ThreadPool* pool);
+void set_ai_planner(AI* ai, struct AIPlanner* planner);
+void calculate_best_path(AI* ai);
 void ai_process(AI* ai, double delta_t);
 
 #endif
\ No newline at end of file
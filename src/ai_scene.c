@@ -7,6 +7,7 @@
 #include "test.h"
 
 #include <stdio.h>
+#include <time.h>
 
 
 /* aiscene global structure */
@@ -15,9 +16,9 @@ AIScene* ai_scene = NULL;
 
 /* aiscene varaibles */
 double ais_delta_t;
-uint64_t ais_start, ais_end;
 bool ais_started = false;
 bool ais_difficulty_choosed = false;
+bool ais_redraw = true;
 const SDL_Rect board_player_pos = { 230, 4, 388, 708 };
 const SDL_Rect board_ai_pos = { 820, 50, 291, 531 };
 const char* txt_victory_player = "Player Wins!";
@@ -48,6 +49,7 @@ bool ais_create_buttons();
 bool ais_create_text();
 
 void ais_show_game_ui(bool show);
+void ais_seed_boards();
 
 /* aiscene callbacks */
 void ais_lines_destroyed_player(int nb_of_lines);
@@ -69,8 +71,11 @@ void ais_extreme_callback();
 
 /**
  * Create the ai scene of the game.
+ *
+ * \param window the main window.
+ * \param scheduler the scheduler of the frames of the game.
 */
-AIScene* create_ai_scene(SDL_Window* window)
+AIScene* create_ai_scene(SDL_Window* window, FrameScheduler* scheduler)
 {
     AIScene* _ai_scene = malloc(sizeof(AIScene));
 	if (_ai_scene == NULL)
@@ -96,6 +101,17 @@ AIScene* create_ai_scene(SDL_Window* window)
 	_ai_scene->ais_clean = &ais_clean;
 	_ai_scene->window = window;
 	_ai_scene->renderer = SDL_GetRenderer(window);
+	_ai_scene->scheduler = scheduler;
+	_ai_scene->board_player = NULL;
+	_ai_scene->board_ai = NULL;
+	_ai_scene->view_player = NULL;
+	_ai_scene->view_ai = NULL;
+	_ai_scene->ai = NULL;
+	_ai_scene->pool = NULL;
+	_ai_scene->planner = NULL;
+	_ai_scene->text_ai = NULL;
+	_ai_scene->text_victory = NULL;
+	_ai_scene->text_choose_difficulty = NULL;
 	ai_scene = _ai_scene;
 	return _ai_scene;
 }
@@ -114,23 +130,36 @@ bool ais_init()
 
     // Board player
     print_color("   Creating board player for AI scene", TXT_GREEN);
-    ai_scene->board_player = create_board(board_player_pos, false, &ais_full_player_callback);
+    ai_scene->board_player = create_board(&ais_full_player_callback, 0);
     if (ai_scene->board_player == NULL)
     {
         print_color("   Error Creating board player for AI scene", TXT_RED);
         return false;
     }
+    ai_scene->view_player = create_board_view(ai_scene->board_player, ai_scene->renderer, board_player_pos, false);
+    if (ai_scene->view_player == NULL)
+    {
+        print_color("   Error Creating board view player for AI scene", TXT_RED);
+        return false;
+    }
     ai_scene->board_player->lines_destroyed_cb = &ais_lines_destroyed_player;
 
     // Board AI
     print_color("   Creating board AI for AI scene", TXT_GREEN);
-    ai_scene->board_ai = create_board(board_ai_pos, true, &ais_full_ai_callback);
+    ai_scene->board_ai = create_board(&ais_full_ai_callback, 0);
     if (ai_scene->board_ai == NULL)
     {
         print_color("   Error Creating board AI for AI scene", TXT_RED);
         return false;
     }
+    ai_scene->view_ai = create_board_view(ai_scene->board_ai, ai_scene->renderer, board_ai_pos, true);
+    if (ai_scene->view_ai == NULL)
+    {
+        print_color("   Error Creating board view AI for AI scene", TXT_RED);
+        return false;
+    }
     ai_scene->board_ai->lines_destroyed_cb = &ais_lines_destroyed_ai;
+    ais_seed_boards();
 
     // AI
     print_color("   Creating AI for the AI scene", TXT_GREEN);
@@ -141,6 +170,36 @@ bool ais_init()
         return false;
     }
 
+    // The weights found by the tuner, next to the executable, the default ones are kept without the file
+    char weights_path[FILENAME_MAX];
+    char* base_path = SDL_GetBasePath();
+    const bool path_found = get_weights_path(base_path != NULL ? base_path : "", weights_path, sizeof(weights_path));
+    SDL_free(base_path);
+    AIWeights weights = ai_scene->ai->weights;
+    if (path_found && load_weights(weights_path, &weights))
+    {
+        print_color("   Loading the tuned weights of the AI from", TXT_GREEN);
+        set_ai_weights(ai_scene->ai, &weights);
+    }
+    else
+        print_color("   No tuned weights for the AI, it uses the default ones, expected in", TXT_GREEN);
+    printf("    %s\n", path_found ? weights_path : AI_WEIGHTS_FILE);
+
+    // The planner searches in the background with the pool, the render thread keeps its core
+    const uint8_t cores = get_number_of_cores();
+    ai_scene->pool = create_thread_pool(cores > 1 ? cores - 1 : 1);
+    if (ai_scene->pool == NULL)
+        print_color("   Error Creating the thread pool of the AI, it uses one thread", TXT_RED);
+    ai_scene->planner = create_ai_planner(ai_scene->pool);
+    if (ai_scene->planner != NULL)
+        set_ai_planner(ai_scene->ai, ai_scene->planner);
+    else
+    {
+        print_color("   Error Creating the planner of the AI, it searches on the render thread", TXT_RED);
+        if (ai_scene->pool != NULL)
+            set_ai_thread_pool(ai_scene->ai, ai_scene->pool);
+    }
+
     // Buttons
     print_color("   Creating buttons for AI scene", TXT_GREEN);
     if (!ais_create_buttons())
@@ -277,8 +336,8 @@ bool ais_create_text()
     const uint8_t text_size = 32;
     const uint8_t key_text_size = 24;
     const uint8_t key_size = 64;
-    const uint16_t text_ai_x = ai_scene->board_ai->pos.x + ((GAME_BOARD.w * ai_scene->board_ai->scale[0]) / 2) - text_size;
-    const uint16_t text_ai_y = ai_scene->board_ai->pos.y - text_size - ai_scene->board_ai->scale[1];
+    const uint16_t text_ai_x = ai_scene->view_ai->pos.x + ((GAME_BOARD.w * ai_scene->view_ai->scale[0]) / 2) - text_size;
+    const uint16_t text_ai_y = ai_scene->view_ai->pos.y - text_size - ai_scene->view_ai->scale[1];
 
     ai_scene->text_ai = create_text("AI", text_ai_x, text_ai_y, text_size);
     if (ai_scene->text_ai == NULL)
@@ -345,17 +404,17 @@ bool ais_create_text()
 uint8_t ais_loop() 
 {
     print_color("AI Scene loop", TXT_BLUE);
+    ais_redraw = true;
     while (!ai_scene->return_code)
     {
-        ais_start = SDL_GetPerformanceCounter();
+        ais_delta_t = begin_frame(ai_scene->scheduler);
 
         ais_event();
         ais_update();
         ais_draw();
 
-        ais_end = SDL_GetPerformanceCounter();
-
-        ais_delta_t = (double)((ais_end - ais_start) * 1000 / (double)SDL_GetPerformanceFrequency());
+        // Nothing moves when the game is not started, wait for an event
+        end_frame(ai_scene->scheduler, !ais_started);
     }
     print_color("End AI Scene loop", TXT_BLUE);
     return ai_scene->return_code;
@@ -370,13 +429,17 @@ void ais_clean()
     print_color("  AI Scene clean", TXT_GREEN);
 
     print_color("    Cleaning board player", TXT_GREEN);
+    if (ai_scene->view_player != NULL) clean_board_view(&ai_scene->view_player);
     if (ai_scene->board_player != NULL) clean_board(&ai_scene->board_player);
 
     print_color("    Cleaning board ai", TXT_GREEN);
+    if (ai_scene->view_ai != NULL) clean_board_view(&ai_scene->view_ai);
     if (ai_scene->board_ai != NULL) clean_board(&ai_scene->board_ai);
 
     print_color("    Cleaning AI", TXT_GREEN);
     if (ai_scene->ai != NULL) clean_ai(&ai_scene->ai);
+    if (ai_scene->planner != NULL) clean_ai_planner(&ai_scene->planner);
+    if (ai_scene->pool != NULL) clean_thread_pool(&ai_scene->pool);
 
     print_color("    Cleaning buttons", TXT_GREEN);
     for (uint8_t i = 0; i < ai_scene->nb_buttons; i++)
@@ -415,9 +478,19 @@ void ais_event()
                 break;
             case SDL_MOUSEBUTTONDOWN:
                 check_buttons_click(ai_scene->buttons, ai_scene->nb_buttons, event.button);
+                ais_redraw = true;
                 break;
             case SDL_MOUSEMOTION:
-                check_buttons_hover(ai_scene->buttons, ai_scene->nb_buttons, event.motion);
+                ais_redraw |= check_buttons_hover(ai_scene->buttons, ai_scene->nb_buttons, event.motion);
+                break;
+            case SDL_WINDOWEVENT:
+                ais_redraw = true;
+                break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                invalidate_board_view(ai_scene->view_player);
+                invalidate_board_view(ai_scene->view_ai);
+                ais_redraw = true;
                 break;
             case SDL_KEYDOWN:
                 ais_keyboard_event(event.key);
@@ -461,14 +534,20 @@ void ais_update()
 */
 void ais_draw() 
 {
+    // Nothing changed, the window keeps the last frame
+    bool boards_changed = board_view_changed(ai_scene->view_player) || board_view_changed(ai_scene->view_ai);
+    if (!ais_redraw && !(ais_difficulty_choosed && boards_changed))
+        return;
+    ais_redraw = false;
+
     SDL_UpdateWindowSurface(ai_scene->window);
     SDL_RenderClear(ai_scene->renderer);
 
     if (ais_difficulty_choosed)
     {
         // Draw the boards
-        draw_board(ai_scene->board_player, ai_scene->renderer);
-        draw_board(ai_scene->board_ai, ai_scene->renderer);
+        draw_board_view(ai_scene->view_player, ai_scene->renderer);
+        draw_board_view(ai_scene->view_ai, ai_scene->renderer);
 
         // Draw texts
         draw_text(ai_scene->text_ai, ai_scene->renderer);
@@ -509,27 +588,38 @@ void ais_show_game_ui(bool show)
 }
 
 
+/**
+ * Give the same new seed to the two boards, the player and the AI get the same tetrominos.
+*/
+void ais_seed_boards()
+{
+    uint64_t seed = (uint64_t) time(NULL);
+    seed_board(ai_scene->board_player, seed);
+    seed_board(ai_scene->board_ai, seed);
+}
+
+
 /* #################### CALLBACK METHODS #################### */
 
 /**
  * Callback method for the lines destroyed by the player.
  * 
- * \param nb_of_lines the number of lines destroyed.
+ * \param nb_of_lines the number of lines sent, the lines destroyed which did not cancel garbage.
 */
 void ais_lines_destroyed_player(int nb_of_lines)
 {
-    add_random_lines(ai_scene->board_ai, nb_of_lines);
+    queue_garbage(ai_scene->board_ai, nb_of_lines);
 }
 
 
 /**
  * Callback method for the lines destroyed by the ai.
  * 
- * \param nb_of_lines the number of lines destroyed.
+ * \param nb_of_lines the number of lines sent, the lines destroyed which did not cancel garbage.
 */
 void ais_lines_destroyed_ai(int nb_of_lines) 
 {
-    add_random_lines(ai_scene->board_player, nb_of_lines);
+    queue_garbage(ai_scene->board_player, nb_of_lines);
 }
 
 
@@ -552,6 +642,7 @@ void ais_restart_callback()
     ais_btn_restart->visible = false;
     reset_board(ai_scene->board_player);
     reset_board(ai_scene->board_ai);
+    ais_seed_boards();
     reset_ai(ai_scene->ai);
     ais_btn_pause->visible = true;
     ais_started = true;
@@ -589,6 +680,7 @@ void ais_back_callback()
     ais_started = false;
     reset_board(ai_scene->board_player);
     reset_board(ai_scene->board_ai);
+    ais_seed_boards();
     reset_ai(ai_scene->ai);
     ais_btn_start->visible = true;
     ais_btn_pause->visible = false;
@@ -606,6 +698,7 @@ void ais_back_callback()
 */
 void ais_full_player_callback() 
 {
+    ais_redraw = true;
     ais_btn_restart->visible = true;
     ais_btn_pause->visible = false;
     ais_started = false;
@@ -619,6 +712,7 @@ void ais_full_player_callback()
 */
 void ais_full_ai_callback() 
 {
+    ais_redraw = true;
     ais_btn_restart->visible = true;
     ais_btn_pause->visible = false;
     ais_started = false;
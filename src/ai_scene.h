@@ -9,8 +9,11 @@
 
 #include "button.h"
 #include "board.h"
+#include "board_view.h"
 #include "text.h"
 #include "ai.h"
+#include "planner.h"
+#include "frame_scheduler.h"
 
 #define AIS_NB_BUTTONS 9
 #define AIS_NB_KEYS 5
@@ -20,13 +23,18 @@ typedef struct AIScene {
     uint8_t nb_buttons;
     SDL_Window* window;
     SDL_Renderer* renderer;
+    FrameScheduler* scheduler;
     bool (*ais_init)();
     uint8_t (*ais_loop)();
     void (*ais_clean)();
     uint8_t return_code;
     Board* board_player;
     Board* board_ai;
+    BoardView* view_player;
+    BoardView* view_ai;
     AI* ai;
+    ThreadPool* pool;
+    AIPlanner* planner;
     Text* text_ai;
     Text* text_victory;
     Text* text_choose_difficulty;
@@ -34,6 +42,6 @@ typedef struct AIScene {
     uint8_t nb_keys;
 } AIScene;
 
-AIScene* create_ai_scene(SDL_Window* window);
+AIScene* create_ai_scene(SDL_Window* window, FrameScheduler* scheduler);
 
 #endif // AI_SCENE_H
@@ -0,0 +1,133 @@
+#include "board.h"
+#include "ai.h"
+#include "thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#define ALLOC_TEST_DELTA_T 16           // The fixed time step of a frame (ms)
+#define ALLOC_TEST_WARMUP_FRAMES 3000   // The frames played before counting, the first searches may allocate
+#define ALLOC_TEST_FRAMES 30000         // The frames played while counting
+#define ALLOC_TEST_THREADS 2            // The workers of the pool of the second game
+
+/* The allocations of the core are linked to the functions below with -Wl,--wrap */
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t number, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t number, size_t size);
+void* __wrap_realloc(void* pointer, size_t size);
+
+static atomic_bool counting = false;
+static atomic_uint allocations = 0;
+
+void alloc_test_full_callback();
+bool run_alloc_test(ThreadPool* pool);
+
+/**
+ * Check that the AI does no heap allocation once its game is started, with and without its thread pool.
+ * usage : alloc_test
+ *
+ * \return 1 if an allocation was counted, 0 else.
+*/
+int main(void)
+{
+    bool passed = run_alloc_test(NULL);
+    ThreadPool* pool = create_thread_pool(ALLOC_TEST_THREADS);
+    if (pool == NULL)
+    {
+        printf("error creating the thread pool\n");
+        return 1;
+    }
+    passed = run_alloc_test(pool) && passed;
+    clean_thread_pool(&pool);
+
+    printf(passed ? "alloc test passed\n" : "alloc test failed\n");
+    return passed ? 0 : 1;
+}
+
+
+/**
+ * Count a malloc while the test is counting.
+*/
+void* __wrap_malloc(size_t size)
+{
+    if (atomic_load(&counting))
+        atomic_fetch_add(&allocations, 1);
+    return __real_malloc(size);
+}
+
+
+/**
+ * Count a calloc while the test is counting.
+*/
+void* __wrap_calloc(size_t number, size_t size)
+{
+    if (atomic_load(&counting))
+        atomic_fetch_add(&allocations, 1);
+    return __real_calloc(number, size);
+}
+
+
+/**
+ * Count a realloc while the test is counting.
+*/
+void* __wrap_realloc(void* pointer, size_t size)
+{
+    if (atomic_load(&counting))
+        atomic_fetch_add(&allocations, 1);
+    return __real_realloc(pointer, size);
+}
+
+
+/**
+ * Callback method called when the board is full, the test checks the board instead.
+*/
+void alloc_test_full_callback()
+{
+}
+
+
+/**
+ * Play a game of the AI, then count the allocations of the next frames.
+ *
+ * \param pool the thread pool of the AI, NULL to only use the calling thread.
+ * \return false if an allocation was counted or the game can't be created.
+*/
+bool run_alloc_test(ThreadPool* pool)
+{
+    Board* board = create_board(&alloc_test_full_callback, 1);
+    AI* ai = board != NULL ? create_ai(board) : NULL;
+    if (ai == NULL)
+    {
+        printf("error creating the game\n");
+        if (board != NULL)
+            clean_board(&board);
+        return false;
+    }
+    set_ai_difficulty(ai, EXTREME);
+    set_ai_thread_pool(ai, pool);
+
+    uint32_t frames = 0;
+    for (; frames < ALLOC_TEST_WARMUP_FRAMES + ALLOC_TEST_FRAMES && !board->full; frames++)
+    {
+        if (frames == ALLOC_TEST_WARMUP_FRAMES)
+        {
+            atomic_store(&allocations, 0);
+            atomic_store(&counting, true);
+        }
+        update_board(board, ALLOC_TEST_DELTA_T);
+        ai_process(ai, ALLOC_TEST_DELTA_T);
+    }
+    atomic_store(&counting, false);
+
+    const unsigned int counted = atomic_load(&allocations);
+    printf("%u threads : %u allocations in %u frames after the warm-up, %u lines\n",
+        pool != NULL ? get_thread_pool_size(pool) : 1, counted,
+        frames > ALLOC_TEST_WARMUP_FRAMES ? frames - ALLOC_TEST_WARMUP_FRAMES : 0, board->lines_destroyed);
+
+    clean_ai(&ai);
+    clean_board(&board);
+    return counted == 0 && frames > ALLOC_TEST_WARMUP_FRAMES;
+}
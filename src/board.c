@@ -2,17 +2,16 @@
 
 #include "print_color.h"
 #include "tetromino.h"
-#include "utils.h"
-#include "global.h"
+#include "replay.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 
 /* Local functions declaration */
 void init_memory(Board* board);
-void init_subboards(Board* board);
-void init_texts(Board* board);
 
 bool move_possible_x(Board* board, int8_t x);
 bool move_possible_y(Board* board, int8_t y);
@@ -20,30 +19,27 @@ void move_tetromino(Board* board, int8_t x, int8_t y);
 
 void summon_tetromino(Board* board);
 void update_tetromino(Board* board);
-void update_positions(Board* board);
-void update_next_tetromino(Board* board);
+void hold_tetromino(Board* board);
+void fill_queue(Board* board);
+BlockType pop_next_block_type(Board* board);
+BlockType next_block_type(Board* board);
 void update_preview(Board* board);
 void update_score(Board* board, uint16_t score_add);
 void update_level(Board* board, uint8_t lines_destroyed);
 void update_gravity(Board* board);
-void update_text(Text* text, uint32_t add_value);
-void destroy_useless_tetrominos(Board* board);
-void sort_board_tetrominos(Board* board, uint8_t start);
+void lock_tetromino(Board* board);
 void check_for_lines(Board* board);
+uint8_t cancel_garbage(Board* board, uint8_t nb_of_lines);
+void add_garbage(Board* board);
 void destroy_lines(Board* board, uint8_t* lines, uint8_t nb_of_lines);
-Square* search_square_by_coord(Board* board, uint8_t x, uint8_t y);
+void remove_lines_from_map(Map* map, const uint8_t* lines, uint8_t nb_of_lines);
+void shift_map_up(Map* map, uint8_t number_of_lines);
 void reset_map(Board* board);
-void reset_mini_map(Board* board);
-void add_tetromino_to_board(Board* board, Tetromino* tetromino);
 void rotate_tetromino(Board* board);
-bool rotation_possible(Board* board, int8_t** moves);
 bool board_is_full(Board* board);
+bool snapshot_is_valid(const BoardSnapshot* snapshot);
 void hard_drop_tetromino(Board* board);
 
-void draw_next_tetromino(Board* board, SDL_Renderer* renderer);
-void draw_map(Board* board, SDL_Renderer* renderer);
-void draw_preview(Board* board, SDL_Renderer* renderer);
-
 uint8_t calculate_lines_before_level_up(Board* board);
 uint16_t calculate_score(Board* board, uint8_t nb_of_lines);
 float calculate_gravity_by_level(uint8_t level);
@@ -53,46 +49,40 @@ float calculate_gravity_by_level(uint8_t level);
 /**
  * Create a board for the game.
  * 
- * \param pos the position of the board.
- * \param show_right if the stats board and next tetromino is showed on the right or left.
+ * \param full_callback the method called when the board is full.
+ * \param seed the seed of the random generators, the same seed gives the same game.
  * \return a new board object.
 */
-Board* create_board(SDL_Rect pos, bool show_right, void (*full_callback)) 
+Board* create_board(void (*full_callback), uint64_t seed)
 {
     Board* board = malloc(sizeof(Board));
     if (board == NULL)
         return NULL;
     board->full_callback = full_callback;
-    board->pos = pos;
-    board->nb_tetrominos = 0;
     board->level = 0;
     board->score = 0;
     board->time = 0;
     board->time_clock = 0;
     board->time_lock = 0;
     board->time_drop = 0;
-    board->number_of_lines_blocked = 0;
     board->full = false;
-    board->show_right = show_right;
     board->lock_delay_passed = true;
     board->lines_before_level_up = calculate_lines_before_level_up(board);
-    board->actual_tetromino = NULL;
+    board->actual_tetromino = spawn_tetromino(B_NONE);
     board->gravity = calculate_gravity_by_level(board->level);
     board->lines_destroyed_cb = NULL;
-
-    // Square size
-    board->square_size[0] = pos.w / (MAP_WIDTH + 2);  // width
-    board->square_size[1] = pos.h / (MAP_HEIGHT + 2); // height
-
-    // Scale
-    board->scale[0] = (float) pos.w / GAME_BOARD.w; // scale x
-    board->scale[1] = (float) pos.h / GAME_BOARD.h; // scale y
+    board->lines_destroyed = 0;
+    board->randomizer = RANDOMIZER_UNIFORM;
+    board->bag = 0;
+    board->hold = B_NONE;
+    board->hold_used = false;
+    memset(board->garbage, 0, sizeof(board->garbage));
+    board->changes = CHANGE_ALL;
+    board->replay = NULL;
 
     init_memory(board);
-    init_subboards(board);
-    init_texts(board);
 
-    update_next_tetromino(board);
+    seed_board(board, seed);
 
     return board;
 }
@@ -105,133 +95,57 @@ Board* create_board(SDL_Rect pos, bool show_right, void (*full_callback))
 */
 void init_memory(Board* board)
 {
-    // Tetrominos
-    board->tetrominos = malloc(MAX_TETROMINOS * sizeof(Tetromino*));
-    for (uint8_t i = 0; i < MAX_TETROMINOS; i++)
-        board->tetrominos[i] = NULL;
-
     // Map
-    board->map = malloc(sizeof(uint8_t*) * MAP_HEIGHT);
-    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
-        board->map[i] = calloc(MAP_WIDTH, sizeof(uint8_t));
-
-    // Map_next
-    board->map_next = malloc(sizeof(uint8_t*) * MINI_MAP_HEIGHT);
-    for (uint8_t i = 0; i < MINI_MAP_HEIGHT; i++)
-        board->map_next[i] = calloc(MINI_MAP_WIDTH, sizeof(uint8_t));
+    reset_map(board);
 
     // Preview
     board->preview = malloc(sizeof(uint8_t*) * NB_SQUARES);
     for (uint8_t i = 0; i < NB_SQUARES; i++)
         board->preview[i] = calloc(2, sizeof(uint8_t));
-
-    // Holes
-    board->holes = calloc(MAP_HEIGHT, sizeof(uint8_t));
-}
-
-
-/**
- * Init all the subboards needed in the board.
- *
- * \param board the board which will contains the subboards.
-*/
-void init_subboards(Board* board) 
-{
-    // Subboard
-    if (board->show_right)
-    {
-        board->pos_subboard.x = board->pos.x + board->pos.w - board->scale[0] - board->square_size[0];
-        board->pos_subboard.y = board->pos.y;
-        board->pos_subboard.w = GAME_SUBBOARD_NEXT.w * board->scale[0];
-        board->pos_subboard.h = GAME_SUBBOARD_NEXT.h * board->scale[1];
-    }
-    else
-    {
-        board->pos_subboard.x = board->pos.x - GAME_SUBBOARD_NEXT.w * board->scale[0] + board->square_size[0] + board->scale[0];
-        board->pos_subboard.y = board->pos.y;
-        board->pos_subboard.w = GAME_SUBBOARD_NEXT.w * board->scale[0];
-        board->pos_subboard.h = GAME_SUBBOARD_NEXT.h * board->scale[1];
-    }
-
-    // Stats board
-    board->pos_stats_board.x = board->pos_subboard.x;
-    board->pos_stats_board.y = board->pos_subboard.y + board->pos_subboard.h - board->scale[0] - board->square_size[0];
-    board->pos_stats_board.w = GAME_STATS.w * board->scale[0];
-    board->pos_stats_board.h = GAME_STATS.h * board->scale[1];
-}
-
-
-/**
- * Init all the texts objects for that board.
- * 
- * \param board the board which will contains the texts.
-*/
-void init_texts(Board* board) 
-{
-    // Level text
-    char* level_text = malloc(2 * sizeof(char));
-    level_text[0] = '0'; level_text[1] = '\0';
-    board->level_text = create_text(level_text,
-        board->pos_stats_board.x + board->pos_stats_board.w / 2 - (8 * board->scale[0]) + 0.5f * board->square_size[0],
-        board->pos_stats_board.y + board->scale[1] + board->square_size[1] * 3 - 0.5f * board->square_size[1],
-        8 * board->scale[0]
-    );
-
-    // Score text
-    char* score_text = malloc(2 * sizeof(char));
-    score_text[0] = '0'; score_text[1] = '\0';
-    board->score_text = create_text(score_text,
-        board->pos_stats_board.x + board->pos_stats_board.w / 2 - (8 * board->scale[0]) + 0.5f * board->square_size[0],
-        board->pos_stats_board.y + board->scale[1] + board->square_size[1] * 7 - 0.5f * board->square_size[1],
-        8 * board->scale[0]
-    );
-
-    // Time text
-    char* time_text = malloc(2 * sizeof(char));
-    time_text[0] = '0'; time_text[1] = '\0';
-    board->time_text = create_text(time_text,
-        board->pos_stats_board.x + board->pos_stats_board.w / 2 - (8 * board->scale[0]) + 0.5f * board->square_size[0],
-        board->pos_stats_board.y + board->scale[1] + board->square_size[1] * 11 - 0.5f * board->square_size[1],
-        8 * board->scale[0]
-    );
 }
 
 
 /**
- * Keyboard event for this board.
+ * Process an input (a move of the player or of the AI) for this board.
  * 
- * \param board the board concerned by the keyboard event.
- * \param key the key pressed.
+ * \param board the board concerned by the input.
+ * \param input the input to process.
 */
-void keyboard_event(Board* board, SDL_Keycode key) 
+void board_input(Board* board, BoardInput input) 
 {
-    if (board->full || board->actual_tetromino == NULL)
+    if (board->full || board->actual_tetromino.block_type == B_NONE)
         return;
+    if (board->replay != NULL)
+        record_input(board->replay, input);
 
     int8_t x = 0;
     int8_t y = 0;
     bool rotate = false;
     bool hard_drop = false;
-    switch(key) 
+    bool hold = false;
+    switch(input) 
     {
-        case SDLK_RIGHT:
-        case SDLK_d:
+        case INPUT_RIGHT:
             x++;
             break;
-        case SDLK_LEFT:
-        case SDLK_q:
+        case INPUT_LEFT:
             x--;
             break;
-        case SDLK_DOWN:
-        case SDLK_s:
+        case INPUT_SOFT_DROP:
             y++;
             break;
-        case SDLK_r:
+        case INPUT_ROTATE:
             rotate = true;
             break;
-        case SDLK_SPACE:
+        case INPUT_HARD_DROP:
             hard_drop = true;
             break;
+        case INPUT_HOLD:
+            hold = true;
+            break;
+        case INPUT_NONE:
+        default:
+            break;
     }
 
     bool need_update = false;
@@ -254,11 +168,14 @@ void keyboard_event(Board* board, SDL_Keycode key)
         need_update = true;
     }
 
-    if(need_update) 
+    if (hold)
     {
-        update_positions(board);
-        update_preview(board);
+        hold_tetromino(board);
+        need_update = true;
     }
+
+    if(need_update) 
+        update_preview(board);
 }
 
 
@@ -270,6 +187,8 @@ void keyboard_event(Board* board, SDL_Keycode key)
 */
 void update_board(Board* board, double delta_t) 
 {
+    if (board->replay != NULL)
+        record_update(board->replay, delta_t);
     if(board->full)
         return;
 
@@ -277,10 +196,13 @@ void update_board(Board* board, double delta_t)
     board->time_drop += delta_t;
 
     // New tetromino
-    if((board->actual_tetromino == NULL || board->actual_tetromino->blocked) && board->lock_delay_passed)
+    if((board->actual_tetromino.block_type == B_NONE || board->actual_tetromino.blocked) && board->lock_delay_passed)
     {
+        lock_tetromino(board);
         check_for_lines(board);
-        destroy_useless_tetrominos(board);
+        add_garbage(board);
+        if (board->full)
+            return;
         board->full = board_is_full(board);
         if (board->full)
         {
@@ -289,14 +211,12 @@ void update_board(Board* board, double delta_t)
         }
         summon_tetromino(board);
         update_preview(board);
-        update_next_tetromino(board);
     }
 
     // Time update for the actual tetromino
     if(board->time_drop * board->gravity >= TIME_UPDATE)
     {
         update_tetromino(board);
-        update_positions(board);
         update_preview(board);
         board->time_drop = 0;
     }
@@ -305,7 +225,7 @@ void update_board(Board* board, double delta_t)
     if(board->time_clock >= MS_SECOND)
     {
         board->time++;
-        update_text(board->time_text, board->time);
+        board->changes |= CHANGE_STATS;
         board->time_clock = 0;
     }
 
@@ -315,45 +235,12 @@ void update_board(Board* board, double delta_t)
 
     if (board->time_lock >= LOCK_DELAY)
     {
-        board->lock_delay_passed = tetromino_blocked(board->map, board->actual_tetromino);
+        board->lock_delay_passed = tetromino_blocked(&board->map, &board->actual_tetromino);
         board->time_lock = 0;
     }
 }
 
 
-/**
- * Draw a board on the screen with the renderer.
- * 
- * \param board the board to draw.
- * \param renderer the renderer of the window
-*/
-void draw_board(Board* board, SDL_Renderer* renderer) 
-{
-    // Draw the board
-    SDL_RenderCopy(renderer, g_game_board, NULL, &board->pos);
-
-    // Draw the preview
-    draw_preview(board, renderer);
-
-    // Draw the map inside the board
-    draw_map(board, renderer);
-
-    // Draw the subboard next tetromino
-    SDL_RenderCopy(renderer, g_game_subboard_next, NULL, &board->pos_subboard);
-
-    // Draw next tetromino
-    draw_next_tetromino(board, renderer);
-
-    // Draw the stats board
-    SDL_RenderCopy(renderer, g_game_stats, NULL, &board->pos_stats_board);
-
-    // Draw the texts
-    draw_text(board->level_text, renderer);
-    draw_text(board->score_text, renderer);
-    draw_text(board->time_text, renderer);
-}
-
-
 /**
  * Correctly clean a board.
  * 
@@ -363,31 +250,10 @@ void clean_board(Board** board)
 {
     Board* _board = (*board);
 
-    free(_board->level_text->text);
-    clean_text(&_board->level_text);
-    free(_board->score_text->text);
-    clean_text(&_board->score_text);
-    free(_board->time_text->text);
-    clean_text(&_board->time_text);
-
-    for(uint8_t i = 0; i < MAP_HEIGHT; i++)
-        free(_board->map[i]);
-    free(_board->map);
-
-    for(uint8_t i = 0; i < MAX_TETROMINOS; i++)
-        if(_board->tetrominos[i] != NULL)
-            clean_tetromino(&_board->tetrominos[i]);
-            
-    for(uint8_t i = 0; i < MINI_MAP_HEIGHT; i++)
-        free(_board->map_next[i]);
-    free(_board->map_next);
-
     for(uint8_t i = 0; i < NB_SQUARES; i++)
         free(_board->preview[i]);
     free(_board->preview);
     
-    free(_board->holes);
-    free(_board->tetrominos);
     free(_board);
     *board = NULL;
 }
@@ -398,69 +264,195 @@ void clean_board(Board** board)
 */
 void reset_board(Board* board) 
 {
-    for (uint8_t i = 0; i < MAX_TETROMINOS; i++)
-        if (board->tetrominos[i] != NULL)
-            clean_tetromino(&board->tetrominos[i]);
+    board->actual_tetromino = spawn_tetromino(B_NONE);
 
-    free(board->level_text->text);
-    clean_text(&board->level_text);
-    free(board->score_text->text);
-    clean_text(&board->score_text);
-    free(board->time_text->text);
-    clean_text(&board->time_text);
-
-    init_texts(board);
-
-    board->nb_tetrominos = 0;
     board->level = 0;
     board->score = 0;
     board->time = 0;
     board->time_clock = 0;
     board->time_lock = 0;
-    board->number_of_lines_blocked = 0;
+    board->lines_destroyed = 0;
     board->full = false;
     board->lock_delay_passed = true;
     board->lines_before_level_up = calculate_lines_before_level_up(board);
-    board->actual_tetromino = NULL;
+    board->hold = B_NONE;
+    board->hold_used = false;
+    memset(board->garbage, 0, sizeof(board->garbage));
 
-    update_next_tetromino(board);
-    update_positions(board);
+    fill_queue(board);
 
     update_gravity(board);
 
     reset_map(board);
+    board->changes = CHANGE_ALL;
 }
 
 
 /**
- * Check if a square [x, y] is blocked in the map.
- * Check if it is outside the map, if there is another tetromino just below.
+ * Seed the random generators of the board and draw new next tetrominos.
+ * Two boards with the same seed get the same tetrominos, whatever the lines they receive.
  *
- * \param map the map associated with the board.
- * \param x the x coordinate of the square.
- * \param y the y coordinate of the square.
- * \param tetromino the actual tetromino.
- * \return true if the square is blocked, false else.
+ * \param board the board concerned.
+ * \param seed the new seed.
+*/
+void seed_board(Board* board, uint64_t seed)
+{
+    board->seed = seed;
+    seed_rng(&board->pieces_rng, seed);
+    seed_rng(&board->garbage_rng, seed ^ 0x9E3779B97F4A7C15ULL);
+    board->bag = 0;
+    fill_queue(board);
+}
+
+
+/**
+ * Change the way the block types of the board are chosen.
+ * The next tetrominos already in the queue are kept.
+ *
+ * \param board the board concerned.
+ * \param randomizer the new randomizer.
 */
-bool square_blocked(uint8_t** map, int8_t x, int8_t y, Tetromino* tetromino)
+void set_randomizer(Board* board, Randomizer randomizer)
 {
-    // If outside the map
-    if (y < -1)
+    board->randomizer = randomizer;
+    board->bag = 0;
+}
+
+
+/**
+ * Get the block type of a next tetromino, without removing it from the queue.
+ *
+ * \param board the board concerned.
+ * \param index the position in the queue, 0 is the next tetromino, must be less than QUEUE_SIZE.
+ * \return the block type of that tetromino.
+*/
+BlockType get_next_block_type(const Board* board, uint8_t index)
+{
+    return board->queue[(board->queue_head + index) % QUEUE_SIZE];
+}
+
+
+/**
+ * Save all the simulation state of the board in a snapshot.
+ *
+ * \param board the board concerned.
+ * \param snapshot the snapshot to be filled.
+*/
+void board_snapshot(const Board* board, BoardSnapshot* snapshot)
+{
+    const Tetromino* tetromino = &board->actual_tetromino;
+    snapshot->time_clock = board->time_clock;
+    snapshot->time_lock = board->time_lock;
+    snapshot->time_drop = board->time_drop;
+    snapshot->pieces_rng = board->pieces_rng;
+    snapshot->garbage_rng = board->garbage_rng;
+    snapshot->score = board->score;
+    memcpy(snapshot->rows, board->map.rows, sizeof(snapshot->rows));
+    snapshot->time = board->time;
+    snapshot->lines_destroyed = board->lines_destroyed;
+    memcpy(snapshot->queue, board->queue, sizeof(snapshot->queue));
+    snapshot->queue_head = board->queue_head;
+    memcpy(snapshot->garbage, board->garbage, sizeof(snapshot->garbage));
+    snapshot->hold = board->hold;
+    snapshot->bag = board->bag;
+    snapshot->randomizer = board->randomizer;
+    snapshot->level = board->level;
+    snapshot->lines_before_level_up = board->lines_before_level_up;
+    snapshot->block_type = tetromino->block_type;
+    snapshot->rotation = tetromino->rotation;
+    snapshot->x = tetromino->x;
+    snapshot->y = tetromino->y;
+    snapshot->flags = (board->full ? SNAPSHOT_FULL : 0)
+        | (board->lock_delay_passed ? SNAPSHOT_LOCK_DELAY_PASSED : 0)
+        | (board->hold_used ? SNAPSHOT_HOLD_USED : 0)
+        | (tetromino->blocked ? SNAPSHOT_BLOCKED : 0);
+}
+
+
+/**
+ * Put the board back in the state of a snapshot, the callbacks of the board are kept.
+ * The squares without color get the color of the added lines.
+ *
+ * \param board the board concerned.
+ * \param snapshot the snapshot to restore, it can come from a file so it is checked first.
+ * \return false if the snapshot is not valid, the board is then unchanged.
+*/
+bool board_restore(Board* board, const BoardSnapshot* snapshot)
+{
+    if (!snapshot_is_valid(snapshot))
+    {
+        print_color("The snapshot of the board is not valid", TXT_RED);
         return false;
+    }
 
-    // Last line
-    if (y + 1 >= MAP_HEIGHT)
-        return true;
+    board->time_clock = snapshot->time_clock;
+    board->time_lock = snapshot->time_lock;
+    board->time_drop = snapshot->time_drop;
+    board->pieces_rng = snapshot->pieces_rng;
+    board->garbage_rng = snapshot->garbage_rng;
+    board->score = snapshot->score;
+    board->time = snapshot->time;
+    board->lines_destroyed = snapshot->lines_destroyed;
+    memcpy(board->queue, snapshot->queue, sizeof(board->queue));
+    board->queue_head = snapshot->queue_head;
+    memcpy(board->garbage, snapshot->garbage, sizeof(board->garbage));
+    board->hold = snapshot->hold;
+    board->bag = snapshot->bag;
+    board->randomizer = snapshot->randomizer;
+    board->level = snapshot->level;
+    board->lines_before_level_up = snapshot->lines_before_level_up;
+    board->full = snapshot->flags & SNAPSHOT_FULL;
+    board->lock_delay_passed = snapshot->flags & SNAPSHOT_LOCK_DELAY_PASSED;
+    board->hold_used = snapshot->flags & SNAPSHOT_HOLD_USED;
+
+    board->actual_tetromino = spawn_tetromino(snapshot->block_type);
+    board->actual_tetromino.rotation = snapshot->rotation;
+    board->actual_tetromino.x = snapshot->x;
+    board->actual_tetromino.y = snapshot->y;
+    board->actual_tetromino.blocked = snapshot->flags & SNAPSHOT_BLOCKED;
+
+    // Keep the colors coherent with the occupancy
+    Map* map = &board->map;
+    memcpy(map->rows, snapshot->rows, sizeof(map->rows));
+    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
+    {
+        for (uint8_t j = 0; j < MAP_WIDTH; j++)
+        {
+            if (!(map->rows[i] & (1 << j)))
+                map->colors[i][j] = C_NONE;
+            else if (map->colors[i][j] == C_NONE)
+                map->colors[i][j] = GRAY;
+        }
+    }
 
-    // There is possibly another tetromino below with the same color
-    if (map[y + 1][x] == (uint8_t)tetromino->color)
-        return !square_in_tetromino(tetromino, x, y + 1);
+    update_heights(board);
+    update_gravity(board);
+    update_preview(board);
+    board->changes = CHANGE_ALL;
+    return true;
+}
 
-    // There is another tetromino below
-    if (map[y + 1][x])
-        return true;
 
-    return false;
+/**
+ * Receive lines of garbage, they wait in the queue of the board and are added when the next tetromino is locked.
+ * The lines destroyed before cancel the lines waiting.
+ *
+ * \param board the board concerned.
+ * \param number_of_lines the number of lines received.
+*/
+void queue_garbage(Board* board, uint8_t number_of_lines)
+{
+    if (number_of_lines == 0)
+        return;
+    if (board->replay != NULL)
+        record_lines(board->replay, number_of_lines);
+
+    // A new batch after the last one, merged with it if the queue is full
+    uint8_t i = 0;
+    while (i < GARBAGE_QUEUE_SIZE - 1 && board->garbage[i])
+        i++;
+    uint16_t lines = board->garbage[i] + number_of_lines;
+    board->garbage[i] = lines > MAP_HEIGHT ? MAP_HEIGHT : lines;
 }
 
 
@@ -473,59 +465,45 @@ bool square_blocked(uint8_t** map, int8_t x, int8_t y, Tetromino* tetromino)
 */
 void add_random_lines(Board* board, uint8_t number_of_lines) 
 {
-    // Move all tetrominos up
-    for (uint8_t i = 0; i < board->nb_tetrominos; i++)
-    {
-        Tetromino* tetromino = board->tetrominos[i];
-        if (tetromino == NULL)
-            continue;
+    if (number_of_lines > MAP_HEIGHT)
+        number_of_lines = MAP_HEIGHT;
 
-        if (same_tetrominos(tetromino, board->actual_tetromino))
-            continue;
+    // The actual tetromino only goes up with the lines if it lies on them
+    Tetromino* tetromino = &board->actual_tetromino;
+    bool has_tetromino = tetromino->block_type != B_NONE;
+    bool move_tetromino = has_tetromino && tetromino_blocked(&board->map, tetromino);
 
-        for (uint8_t j = 0; j < tetromino->nb_squares; j++)
-        {
-            Square* square = tetromino->squares[j];
-            square->y -= number_of_lines;
-        }
-    }
+    // The squares pushed above the map are lost, the board is full
+    bool overflow = false;
+    for (uint8_t i = 0; i < number_of_lines; i++)
+        if (board->map.rows[i])
+            overflow = true;
 
-    if (tetromino_blocked(board->map, board->actual_tetromino))
-    {
-        for (uint8_t j = 0; j < board->actual_tetromino->nb_squares; j++)
-        {
-            Square* square = board->actual_tetromino->squares[j];
-            square->y -= number_of_lines;
-        }
-    }
+    shift_map_up(&board->map, number_of_lines);
+    update_heights(board);
+
+    if (move_tetromino)
+        tetromino->y -= number_of_lines;
 
-    // Move holes up
-    if (board->number_of_lines_blocked > 0) 
+    // Add the new lines with a random hole
+    for (uint8_t i = 0; i < number_of_lines; i++)
     {
-        for (uint8_t i = 0; i < board->number_of_lines_blocked; i++) 
-        {
-            int8_t new_index = MAP_HEIGHT - board->number_of_lines_blocked - number_of_lines + i;
-            if (new_index < 0)
-                continue;
-            board->holes[new_index] = board->holes[MAP_HEIGHT - board->number_of_lines_blocked + i];
-        }
-    }    
+        uint8_t line = MAP_HEIGHT - 1 - i;
+        uint8_t hole = random_below(&board->garbage_rng, MAP_WIDTH);
+        board->map.rows[line] = FULL_MASK & ~(1 << hole);
+        memset(board->map.colors[line], GRAY, MAP_WIDTH);
+        board->map.colors[line][hole] = C_NONE;
+    }
+    update_heights(board);
+    board->changes |= CHANGE_MAP;
 
-    if (board->number_of_lines_blocked + number_of_lines >= MAP_HEIGHT - 1)
+    if (overflow)
     {
         board->full = true;
         board->full_callback();
         return;
     }
 
-    // Add new random holes
-    for (uint8_t i = 0; i < number_of_lines; i++)
-    {
-        uint8_t random = rand() % MAP_WIDTH;
-        board->holes[MAP_HEIGHT - 1 - i] = random;
-    }
-    board->number_of_lines_blocked = fmin(board->number_of_lines_blocked + number_of_lines, MAP_HEIGHT - 1);
-    update_positions(board);
     update_preview(board);
     board->full = board_is_full(board);
     if (board->full)
@@ -534,37 +512,72 @@ void add_random_lines(Board* board, uint8_t number_of_lines)
 
 
 /**
- * Check with the movement of x amount is possible.
- * 
+ * Compute the height of each column from the map.
+ * The map must only contain the locked squares.
+ *
  * \param board the board concerned.
- * \param x the amount of x coordinate to be added to all the squares of the tetromino.
- * \return true if the move is possible, false else.
 */
-bool move_possible_x(Board* board, int8_t x) 
+void update_heights(Board* board)
 {
-    Tetromino* tetromino = board->actual_tetromino;
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-    {
-        Square* square = tetromino->squares[i];
+    get_map_heights(&board->map, board->heights);
+}
 
-        if (square->x + x > MAP_WIDTH - 1 || square->x + x < 0)
-            return false;
 
-        if (square->y < 0)
+/**
+ * Get the height of each column of a map.
+ *
+ * \param map the map concerned.
+ * \param heights the line of the highest square of each column, MAP_HEIGHT if empty.
+*/
+void get_map_heights(const Map* map, uint8_t* heights)
+{
+    memset(heights, MAP_HEIGHT, MAP_WIDTH);
+
+    // The first line where a column appears is its height
+    uint16_t found = 0;
+    for (uint8_t line = 0; line < MAP_HEIGHT && found != FULL_MASK; line++)
+    {
+        uint16_t new_columns = map->rows[line] & ~found;
+        if (!new_columns)
             continue;
 
-        if (board->map[square->y][square->x + x] == (int)tetromino->color)
-        {
-            if (!square_in_tetromino(tetromino, square->x + x, square->y))
-                return false;
-            else
-                continue;
-        }
+        for (uint8_t x = 0; x < MAP_WIDTH; x++)
+            if (new_columns & (1 << x))
+                heights[x] = line;
+        found |= new_columns;
+    }
+}
 
-        if (board->map[square->y][square->x + x])
-            return false;
+
+/**
+ * Add the squares of the tetromino inside the map.
+ *
+ * \param map the map concerned.
+ * \param tetromino the tetromino to be added.
+*/
+void add_tetromino_to_map(Map* map, const Tetromino* tetromino)
+{
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
+    {
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.x < 0 || square.y < 0 || square.x >= MAP_WIDTH || square.y >= MAP_HEIGHT)
+            continue;
+        map->rows[square.y] |= 1 << square.x;
+        map->colors[square.y][square.x] = tetromino->color;
     }
-    return true;
+}
+
+
+/**
+ * Check with the movement of x amount is possible.
+ * 
+ * \param board the board concerned.
+ * \param x the amount of x coordinate to be added to all the squares of the tetromino.
+ * \return true if the move is possible, false else.
+*/
+bool move_possible_x(Board* board, int8_t x) 
+{
+    return !tetromino_collides(&board->map, &board->actual_tetromino, x, 0);
 }
 
 
@@ -577,14 +590,8 @@ bool move_possible_x(Board* board, int8_t x)
 */
 bool move_possible_y(Board* board, int8_t y) 
 {
-    Tetromino* tetromino = board->actual_tetromino;
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-    {
-        Square* square = tetromino->squares[i];
-        if(square_blocked(board->map, square->x, square->y + y, tetromino)) 
-            return false;
-    }
-    return true;
+    // The tetromino must not be blocked once moved
+    return !tetromino_collides(&board->map, &board->actual_tetromino, 0, y + 1);
 }
 
 
@@ -609,13 +616,12 @@ void move_tetromino(Board* board, int8_t x, int8_t y)
         if(!move_possible_y(board, y))
             return;
 
-    for(uint8_t i = 0; i < board->actual_tetromino->nb_squares; i++)
-    {
-        Square* square = board->actual_tetromino->squares[i];
-        
-        square->x += x;
-        square->y += y;
-    }
+    if (!x && !y)
+        return;
+
+    board->actual_tetromino.x += x;
+    board->actual_tetromino.y += y;
+    board->changes |= CHANGE_MAP;
 
     if(y)
         update_score(board, SCORE_PER_SOFT_DROP);
@@ -631,8 +637,11 @@ void move_tetromino(Board* board, int8_t x, int8_t y)
 */
 void summon_tetromino(Board* board) 
 {
-    add_tetromino_to_board(board, board->next_tetromino);
-    board->actual_tetromino = board->next_tetromino;
+    board->actual_tetromino = spawn_tetromino(pop_next_block_type(board));
+    board->hold_used = false;
+    board->changes |= CHANGE_MAP;
+    if (board->replay != NULL)
+        record_piece(board->replay);
 }
 
 
@@ -643,75 +652,103 @@ void summon_tetromino(Board* board)
 */
 void update_tetromino(Board* board) 
 {
-    Tetromino* tetromino = board->actual_tetromino;
+    Tetromino* tetromino = &board->actual_tetromino;
 
-    if(tetromino_blocked(board->map, tetromino))
+    if(tetromino_blocked(&board->map, tetromino))
     {
         tetromino->blocked = true;
         board->lock_delay_passed = false;
         return;
     }
 
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-        tetromino->squares[i]->y++;
+    tetromino->y++;
+    board->changes |= CHANGE_MAP;
 }
 
 
 /**
- * Update all the tetrominos position to the map.
+ * Swap the actual tetromino with the held one, or with the next one if nothing is held.
+ * The tetromino coming out starts again from its spawn position.
+ * It can only be done once per tetromino.
  * 
- * \param board to board to update the positions.
+ * \param board the board concerned.
 */
-void update_positions(Board* board) 
+void hold_tetromino(Board* board) 
 {
-    reset_map(board);
+    if (board->hold_used)
+        return;
 
-    // Foreach tetrominos, copy position in the map
-    for(uint8_t i = 0; i < board->nb_tetrominos; i++)
-    {
-        Tetromino* tetromino = board->tetrominos[i];
-        if (tetromino == NULL)
-            continue;
+    BlockType held = board->hold;
+    board->hold = board->actual_tetromino.block_type;
+    board->actual_tetromino = spawn_tetromino(held != B_NONE ? held : pop_next_block_type(board));
+    board->hold_used = true;
+    board->changes |= CHANGE_MAP | CHANGE_STATS;
+}
 
-        for(uint8_t j = 0; j < tetromino->nb_squares; j++)
-        {
-            Square* square = tetromino->squares[j];
-            if(square->x < 0 || square->y < 0 || square->x >= MAP_WIDTH || square->y >= MAP_HEIGHT || !square->alive)
-                continue;
-            board->map[square->y][square->x] = tetromino->color;
-        }
-    }
 
-    // Foreach lines blocked
-    for (uint8_t i = 0; i < board->number_of_lines_blocked; i++) 
-    {
-        for (uint8_t j = 0; j < MAP_WIDTH; j++)
-        {
-            if (j == board->holes[MAP_HEIGHT - i - 1])
-                continue;
-            board->map[MAP_HEIGHT - i - 1][j] = GRAY;
-        }
-    }
+/**
+ * Fill all the queue of the board with new block types.
+ * 
+ * \param board the board concerned.
+*/
+void fill_queue(Board* board) 
+{
+    board->queue_head = 0;
+    for (uint8_t i = 0; i < QUEUE_SIZE; i++)
+        board->queue[i] = next_block_type(board);
+    board->changes |= CHANGE_NEXT;
 }
 
 
 /**
- * Update the next tetromino for the board.
- * Get a new random tetromino.
+ * Take the next block type out of the queue, a new one is chosen at the end of the queue.
  * 
  * \param board the board concerned.
+ * \return the block type taken.
+*/
+BlockType pop_next_block_type(Board* board) 
+{
+    BlockType block_type = board->queue[board->queue_head];
+    board->queue[board->queue_head] = next_block_type(board);
+    board->queue_head = (board->queue_head + 1) % QUEUE_SIZE;
+    board->changes |= CHANGE_NEXT;
+    return block_type;
+}
+
+
+/**
+ * Choose the block type of the next tetromino with the randomizer of the board.
+ *
+ * \param board the board concerned.
+ * \return the block type chosen.
 */
-void update_next_tetromino(Board* board) 
+BlockType next_block_type(Board* board)
 {
-    reset_mini_map(board);
+    if (board->randomizer == RANDOMIZER_UNIFORM)
+        return random_below(&board->pieces_rng, B_MAX - 1) + 1;
 
-    board->next_tetromino = get_random_tetromino();
+    // Refill the bag with all the block types
+    if (!board->bag)
+        board->bag = ((1 << B_MAX) - 1) & ~(1 << B_NONE);
 
-    for(uint8_t i = 0; i < board->next_tetromino->nb_squares; i++)
+    // Take the n-th block type remaining in the bag
+    uint8_t remaining = 0;
+    for (uint8_t type = B_NONE + 1; type < B_MAX; type++)
+        if (board->bag & (1 << type))
+            remaining++;
+
+    uint8_t index = random_below(&board->pieces_rng, remaining);
+    for (uint8_t type = B_NONE + 1; type < B_MAX; type++)
     {
-        Square* square = board->next_tetromino->squares[i];
-        board->map_next[square->y + 3][square->x - 2] = (uint8_t) board->next_tetromino->color;
+        if (!(board->bag & (1 << type)))
+            continue;
+        if (index-- == 0)
+        {
+            board->bag &= ~(1 << type);
+            return type;
+        }
     }
+    return B_NONE;
 }
 
 
@@ -722,35 +759,17 @@ void update_next_tetromino(Board* board)
 */
 void update_preview(Board* board) 
 {
-    Tetromino* tetromino = board->actual_tetromino;
+    const Tetromino* tetromino = &board->actual_tetromino;
 
-    // Set the preview coordinates for all squares
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-    {
-        Square* square = tetromino->squares[i];
-        board->preview[i][0] = square->x;
-        board->preview[i][1] = square->y;
-    }
+    // Move down while the tetromino is not blocked
+    int8_t distance = drop_distance(&board->map, board->heights, tetromino);
 
-    bool blocked = false;
-    while(!blocked) 
+    // Set the preview coordinates for all squares
+    for(uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        // Check if blocked
-        for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-        {
-            Square* square = tetromino->squares[i];
-
-            if(square_blocked(board->map, square->x, board->preview[i][1], tetromino))
-            {
-                blocked = true;
-                break;
-            }
-        }
-
-        // Move down
-        if(!blocked)
-            for(uint8_t i = 0; i < tetromino->nb_squares; i++)
-                board->preview[i][1]++;
+        Square square = get_tetromino_square(tetromino, i);
+        board->preview[i][0] = square.x;
+        board->preview[i][1] = square.y + distance;
     }
 }
 
@@ -764,7 +783,8 @@ void update_preview(Board* board)
 void update_score(Board* board, uint16_t score_add)
 {
     board->score += score_add;
-    update_text(board->score_text, board->score);
+    if (score_add)
+        board->changes |= CHANGE_STATS;
 }
 
 
@@ -783,10 +803,10 @@ void update_level(Board* board, uint8_t lines_destroyed)
         lines_destroyed -= board->lines_before_level_up;
         board->lines_before_level_up = calculate_lines_before_level_up(board);
         board->lines_before_level_up -= lines_destroyed;
-        update_text(board->level_text, board->level);        
     }
     else
         board->lines_before_level_up -= lines_destroyed;
+    board->changes |= CHANGE_STATS;
     /*printf("Level : %d | Lines to be destroyed : %d\n", board->level, board->lines_before_level_up);*/
 }
 
@@ -803,61 +823,26 @@ void update_gravity(Board* board)
 
 
 /**
- * Update a certain text for a certain board with a new value.
- * 
- * \param text the text object to be updated.
- * \param add_value the value to be added to the value of the text.
-*/
-void update_text(Text* text, uint32_t new_value) 
-{
-    uint32_t value = atoi(text->text);
-    uint8_t digits_before = number_of_digits(value);
-    uint8_t digits_after = number_of_digits(new_value);
-    if(digits_after != digits_before) 
-    {
-        text->pos.x -= (text->size * 0.32f) * (digits_after - digits_before);
-        text->text = realloc(text->text, (digits_after + 1) * sizeof(char));
-    }
-    int size = sprintf(text->text, "%d", new_value);
-    text->text[size] = '\0';
-}
-
-
-/**
- * Destroy the tetrominos in the board that aren't draw anymore.
+ * Lock the actual tetromino of the board.
+ * Its squares are added to the map, the board has no actual tetromino anymore.
  *
  * \param board the board concerned.
 */
-void destroy_useless_tetrominos(Board* board) 
+void lock_tetromino(Board* board)
 {
-    uint8_t size = board->nb_tetrominos;
-    for(uint8_t i = 0; i < size; i++) 
-    {
-        Tetromino* tetromino = board->tetrominos[i];
-        if (tetromino == NULL)
-            continue;
+    Tetromino* tetromino = &board->actual_tetromino;
+    if (tetromino->block_type == B_NONE)
+        return;
 
-        if (tetromino_is_dead(tetromino))
-        {
-            clean_tetromino(&tetromino);
-            sort_board_tetrominos(board, i);
-            board->nb_tetrominos--;
-        }
+    add_tetromino_to_map(&board->map, tetromino);
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
+    {
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.y >= 0 && square.y < board->heights[square.x])
+            board->heights[square.x] = square.y;
     }
-}
-
-
-/**
- * Take all the tetrominos after the ith position and move them one position back.
- * 
- * \param board the board concerned.
- * \param start the starting position.
-*/
-void sort_board_tetrominos(Board* board, uint8_t start)
-{
-    for(uint8_t i = start; i < board->nb_tetrominos; i++) 
-        if(i + 1 < MAX_TETROMINOS)
-            board->tetrominos[i] = board->tetrominos[i + 1];
+    board->actual_tetromino = spawn_tetromino(B_NONE);
+    board->changes |= CHANGE_MAP;
 }
 
 
@@ -868,18 +853,12 @@ void sort_board_tetrominos(Board* board, uint8_t start)
 */
 void check_for_lines(Board* board)
 {
-    uint8_t* lines = malloc(sizeof(uint8_t) * 4); // 4 = Max of line to be destroyed at once
+    uint8_t lines[4]; // 4 = Max of line to be destroyed at once
     uint8_t nb_of_lines = 0;
     for(uint8_t i = 0; i < MAP_HEIGHT; i++)
     {
-        uint8_t nb_of_squares = 0;
-        for(uint8_t j = 0; j < MAP_WIDTH; j++)
-        {
-            if(board->map[i][j])
-                nb_of_squares++;
-        }
         // There is a full line
-        if (nb_of_squares == MAP_WIDTH)
+        if (board->map.rows[i] == FULL_MASK)
         {
             lines[nb_of_lines] = i;
             nb_of_lines++;
@@ -890,10 +869,57 @@ void check_for_lines(Board* board)
     if (nb_of_lines) 
     {
         destroy_lines(board, lines, nb_of_lines);
-        if (board->lines_destroyed_cb != NULL)
-            board->lines_destroyed_cb(nb_of_lines);
+        uint8_t nb_sent = cancel_garbage(board, nb_of_lines);
+        if (nb_sent && board->lines_destroyed_cb != NULL)
+            board->lines_destroyed_cb(nb_sent);
     }
-    free(lines);
+}
+
+
+/**
+ * Cancel the garbage waiting in the queue with destroyed lines, the oldest batches first.
+ *
+ * \param board the board concerned.
+ * \param nb_of_lines the number of lines destroyed.
+ * \return the number of lines left after the cancel, sent to the opponent.
+*/
+uint8_t cancel_garbage(Board* board, uint8_t nb_of_lines)
+{
+    uint8_t i = 0;
+    while (nb_of_lines && i < GARBAGE_QUEUE_SIZE && board->garbage[i])
+    {
+        uint8_t cancelled = nb_of_lines < board->garbage[i] ? nb_of_lines : board->garbage[i];
+        board->garbage[i] -= cancelled;
+        nb_of_lines -= cancelled;
+        if (!board->garbage[i])
+            i++;
+    }
+
+    // Remove the empty batches
+    if (i)
+    {
+        memmove(board->garbage, board->garbage + i, GARBAGE_QUEUE_SIZE - i);
+        memset(board->garbage + GARBAGE_QUEUE_SIZE - i, 0, i);
+    }
+    return nb_of_lines;
+}
+
+
+/**
+ * Add all the garbage waiting in the queue to the board at once, after a lock.
+ *
+ * \param board the board concerned.
+*/
+void add_garbage(Board* board)
+{
+    uint16_t nb_of_lines = 0;
+    for (uint8_t i = 0; i < GARBAGE_QUEUE_SIZE && board->garbage[i]; i++)
+        nb_of_lines += board->garbage[i];
+    if (!nb_of_lines)
+        return;
+
+    memset(board->garbage, 0, sizeof(board->garbage));
+    add_random_lines(board, nb_of_lines > MAP_HEIGHT ? MAP_HEIGHT : nb_of_lines);
 }
 
 
@@ -917,44 +943,9 @@ void destroy_lines(Board* board, uint8_t* lines, uint8_t nb_of_lines)
     }
     printf("] (%d) need to be destroyed\n", nb_of_lines);*/
 
-    uint8_t lines_blocked = 0;
-    for (uint8_t i = 0; i < nb_of_lines; i++)
-        if (lines[i] >= MAP_HEIGHT - board->number_of_lines_blocked)
-            lines_blocked++;
-
-    board->number_of_lines_blocked -= lines_blocked;
-
-    // First: delete the lines completed
-    for (uint8_t i = 0; i < nb_of_lines; i++)
-    {
-        uint8_t line = lines[i];
-        for (uint8_t j = 0; j < MAP_WIDTH; j++)
-        {
-            Square* square = search_square_by_coord(board, j, line);
-            if (square == NULL)
-                continue;
-            square->alive = false;
-        }
-    }
-
-    // Second: lower the upper lines
-    for (uint8_t i = 0; i < nb_of_lines; i++)
-    {
-        uint8_t line_destroyed = lines[i];
-        for(uint8_t line = 0; line < line_destroyed; line++)
-        {
-            for (uint8_t column = 0; column < MAP_WIDTH; column++)
-            {
-                if (!board->map[line][column])
-                    continue;
-                Square* square = search_square_by_coord(board, column, line);
-                if (square == NULL)
-                    continue;
-                square->y += 1;
-            }
-        }
-        update_positions(board);
-    }
+    remove_lines_from_map(&board->map, lines, nb_of_lines);
+    update_heights(board);
+    board->changes |= CHANGE_MAP;
 
     update_level(board, nb_of_lines);
     update_gravity(board);
@@ -963,91 +954,129 @@ void destroy_lines(Board* board, uint8_t* lines, uint8_t nb_of_lines)
 
 
 /**
- * Search a square with its coordinates.
+ * Reset all the map of the board to the initial state.
  * 
- * \param board the board concerned.
- * \param x the x coordinate of the square (the column).
- * \param y the y coordinate of the square (the line)
- * \return the square if found, NULL else.
+ * \param board the board containing the map to be reseted.
 */
-Square* search_square_by_coord(Board* board, uint8_t x, uint8_t y) 
+void reset_map(Board* board) 
 {
-    for(uint8_t i = 0; i < board->nb_tetrominos; i++) 
-    {   
-        Tetromino* tetromino = board->tetrominos[i];
-        if (tetromino == NULL)
-            continue;
+    memset(&board->map, 0, sizeof(Map));
+    memset(board->heights, MAP_HEIGHT, MAP_WIDTH);
+}
 
-        for (uint8_t j = 0; j < tetromino->nb_squares; j++)
+
+/**
+ * Remove lines from the map in one pass, the lines above go down.
+ *
+ * \param map the map concerned.
+ * \param lines the index of the lines to be removed, from up to down.
+ * \param nb_of_lines the number of lines to be removed.
+*/
+void remove_lines_from_map(Map* map, const uint8_t* lines, uint8_t nb_of_lines)
+{
+    int8_t next_line = nb_of_lines - 1;
+    int8_t destination = MAP_HEIGHT - 1;
+    for (int8_t line = MAP_HEIGHT - 1; line >= 0; line--)
+    {
+        if (next_line >= 0 && lines[next_line] == line)
+        {
+            next_line--;
+            continue;
+        }
+        if (destination != line)
         {
-            Square* square = tetromino->squares[j];
-            if (square->x == x && square->y == y && square->alive)
-                return square;
+            map->rows[destination] = map->rows[line];
+            memcpy(map->colors[destination], map->colors[line], MAP_WIDTH);
         }
+        destination--;
+    }
+
+    // The lines at the top are now empty
+    for (; destination >= 0; destination--)
+    {
+        map->rows[destination] = 0;
+        memset(map->colors[destination], C_NONE, MAP_WIDTH);
     }
-    return NULL;
 }
 
 
 /**
- * Reset all the map of the board to the initial state.
- * 
- * \param board the board containing the map to be reseted.
+ * Move all the lines of the map up, the lines at the top are lost
+ * and the lines at the bottom are empty.
+ *
+ * \param map the map concerned.
+ * \param number_of_lines the number of lines to move up.
 */
-void reset_map(Board* board) 
+void shift_map_up(Map* map, uint8_t number_of_lines)
 {
-    for(uint8_t i = 0; i < MAP_HEIGHT; i++)
-        for (uint8_t j = 0; j < MAP_WIDTH; j++)
-            board->map[i][j] = 0;
+    uint8_t kept = MAP_HEIGHT - number_of_lines;
+    memmove(map->rows, map->rows + number_of_lines, kept * sizeof(uint16_t));
+    memmove(map->colors, map->colors + number_of_lines, kept * MAP_WIDTH);
+    memset(map->rows + kept, 0, number_of_lines * sizeof(uint16_t));
+    memset(map->colors + kept, C_NONE, number_of_lines * MAP_WIDTH);
 }
 
 
 /**
- * Reset all the mini-map (map for next tetromino) of the board to the initial state.
+ * Check if the tetromino is on the ground on the board.
  * 
- * \param board the board containing the mini-map to be reseted.
+ * \param board the board of the tetromino.
+ * \param tetromino the tetromino to search if it is on ground.
+ * \return true if the tetromino is blocked, false else.
 */
-void reset_mini_map(Board* board) 
+bool tetromino_blocked(const Map* map, const Tetromino* tetromino) 
 {
-    for(uint8_t i = 0; i < MINI_MAP_HEIGHT; i++)
-        for (uint8_t j = 0; j < MINI_MAP_WIDTH; j++)
-            board->map_next[i][j] = 0;
+    return tetromino_collides(map, tetromino, 0, 1);
 }
 
 
 /**
- * Add a tetromino to the board.
- * 
- * \param board the board.
+ * Check if the tetromino moved by [x, y] is outside the map or overlaps
+ * a locked square of the map.
+ * The lines above the map never collide.
+ *
+ * \param map the map associated with the board.
+ * \param tetromino the tetromino to be checked.
+ * \param x the amount of x coordinate to be added to all the squares of the tetromino.
+ * \param y the amount of y coordinate to be added to all the squares of the tetromino.
+ * \return true if the tetromino collides, false else.
 */
-void add_tetromino_to_board(Board* board, Tetromino* tetromino) 
+bool tetromino_collides(const Map* map, const Tetromino* tetromino, int8_t x, int8_t y)
 {
-    for(uint8_t i = 0; i < MAX_TETROMINOS; i++)
-    {
-        if (board->tetrominos[i] == NULL)
-        {
-            board->tetrominos[i] = tetromino;
-            board->nb_tetrominos++;
-            return;
-        }
-    }
+    const PieceShape* shape = get_tetromino_shape(tetromino);
+    int8_t column = tetromino->x + shape->left + x;
+    if (column < 0 || column + shape->width > MAP_WIDTH)
+        return true;
+    return tetromino_overlaps(map, tetromino, x, y);
 }
 
 
 /**
- * Check if the tetromino is on the ground on the board.
- * 
- * \param board the board of the tetromino.
- * \param tetromino the tetromino to search if it is on ground.
- * \return true if the tetromino is blocked, false else.
+ * Check if the tetromino moved by [x, y] is below the last line or overlaps
+ * a locked square of the map.
+ * The columns are not checked, the squares outside of them never overlap.
+ *
+ * \param map the map associated with the board.
+ * \param tetromino the tetromino to be checked.
+ * \param x the amount of x coordinate to be added to all the squares of the tetromino.
+ * \param y the amount of y coordinate to be added to all the squares of the tetromino.
+ * \return true if the tetromino overlaps, false else.
 */
-bool tetromino_blocked(uint8_t** map, Tetromino* tetromino) 
+bool tetromino_overlaps(const Map* map, const Tetromino* tetromino, int8_t x, int8_t y)
 {
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
+    const PieceShape* shape = get_tetromino_shape(tetromino);
+    int8_t column = tetromino->x + shape->left + x;
+    int8_t top = tetromino->y + shape->top + y;
+    for (uint8_t i = 0; i < shape->height; i++)
     {
-        Square* square = tetromino->squares[i];
+        int8_t line = top + i;
+        if (line < 0)
+            continue;
+        if (line >= MAP_HEIGHT)
+            return true;
 
-        if (square_blocked(map, square->x, square->y, tetromino))
+        uint16_t mask = column >= 0 ? shape->rows[i] << column : shape->rows[i] >> -column;
+        if (map->rows[line] & mask)
             return true;
     }
     return false;
@@ -1055,50 +1084,61 @@ bool tetromino_blocked(uint8_t** map, Tetromino* tetromino)
 
 
 /**
- * Try to rotate the actual tetromino of the board.
- * 
- * \param board the board concerned.
+ * Get the number of lines the tetromino can go down before being blocked.
+ * Above the highest locked square of its columns, the distance comes from the heights.
+ * Under an overhang or outside the columns, the tetromino goes down line by line.
+ *
+ * \param map the map associated with the board.
+ * \param heights the line of the highest locked square of each column of the map.
+ * \param tetromino the tetromino to drop.
+ * \return the number of lines to go down.
 */
-void rotate_tetromino(Board* board) 
+int8_t drop_distance(const Map* map, const uint8_t* heights, const Tetromino* tetromino)
 {
-    Tetromino* tetromino = board->actual_tetromino;
-    
-    int8_t** moves = get_next_rotation_moves(tetromino);
-    if (rotation_possible(board, moves)) 
+    int8_t distance = INT8_MAX;
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        for(uint8_t i = 0; i < tetromino->nb_squares; i++)
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.x < 0 || square.x >= MAP_WIDTH || square.y >= heights[square.x])
         {
-            tetromino->squares[i]->x += moves[i][0];
-            tetromino->squares[i]->y += moves[i][1];
+            distance = 0;
+            while (!tetromino_collides(map, tetromino, 0, distance + 1))
+                distance++;
+            return distance;
         }
-        update_rotation(tetromino);
-    }
 
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-        free(moves[i]);
-    free(moves);
+        int8_t square_distance = heights[square.x] - 1 - square.y;
+        if (square_distance < distance)
+            distance = square_distance;
+    }
+    return distance;
 }
 
 
 /**
- * Check if the rotation of the actual tetromino for this board
- * is possible with theses moves.
+ * Try to rotate the actual tetromino of the board clockwise.
+ * The wall kicks of the tetromino are tested in order, the first one not colliding moves it.
  * 
  * \param board the board concerned.
- * \param moves the array of moves [nb_squares][x & y].
- * \return true if the rotation is possible, false else.
 */
-bool rotation_possible(Board* board, int8_t** moves)
+void rotate_tetromino(Board* board) 
 {
-    Tetromino* tetromino = board->actual_tetromino;
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
+    Tetromino* tetromino = &board->actual_tetromino;
+    const Square* kicks = get_rotation_kicks(tetromino);
+
+    Tetromino rotated = *tetromino;
+    update_rotation(&rotated);
+    for (uint8_t i = 0; i < NB_KICKS; i++)
     {
-        Square* square = tetromino->squares[i];
+        if (tetromino_collides(&board->map, &rotated, kicks[i].x, kicks[i].y))
+            continue;
 
-        if (square_blocked(board->map, square->x + moves[i][0], square->y + moves[i][1], tetromino))
-            return false;
+        rotated.x += kicks[i].x;
+        rotated.y += kicks[i].y;
+        *tetromino = rotated;
+        board->changes |= CHANGE_MAP;
+        return;
     }
-    return true;
 }
 
 
@@ -1109,128 +1149,81 @@ bool rotation_possible(Board* board, int8_t** moves)
 */
 bool board_is_full(Board* board) 
 {
-    for (uint8_t i = 0; i < MAP_WIDTH; i++)
-        if (board->map[0][i] && (!square_in_tetromino(board->actual_tetromino, i, 0) || tetromino_blocked(board->map, board->actual_tetromino)))
-            return true;
-    return false;
-}
-
+    if (board->map.rows[0])
+        return true;
 
-/**
- * Do a hard drop for that board.
- * "Teleport" the actual tetromino to the preview.
- * 
- * \param board the board concerned.
-*/
-void hard_drop_tetromino(Board* board) 
-{
-    Tetromino* tetromino = board->actual_tetromino;
-    uint8_t score = 0;
-    for (uint8_t i = 0; i < tetromino->nb_squares; i++)
-    {
-        Square* square = tetromino->squares[i];
-        score += (board->preview[i][1] - square->y) * 2;
-        square->x = board->preview[i][0];
-        square->y = board->preview[i][1];
-    }
-    tetromino->blocked = true;
-    board->lock_delay_passed = true;
-    update_score(board, score);
+    // The actual tetromino is blocked on the first line
+    const Tetromino* tetromino = &board->actual_tetromino;
+    if (tetromino->block_type == B_NONE)
+        return false;
+    const PieceShape* shape = get_tetromino_shape(tetromino);
+    int8_t top = tetromino->y + shape->top;
+    if (top > 0 || top + shape->height <= 0)
+        return false;
+    return tetromino_blocked(&board->map, tetromino);
 }
 
 
-/* #################### DRAW #################### */
-
 /**
- * Draw the map of the board.
- * 
- * \param board the board concerned.
- * \param renderer the renderer of the window.
+ * Check that a snapshot only has values the board can use as indexes.
+ *
+ * \param snapshot the snapshot concerned.
+ * \return false if a value is out of its range.
 */
-void draw_map(Board* board, SDL_Renderer* renderer) 
+bool snapshot_is_valid(const BoardSnapshot* snapshot)
 {
-    SDL_Rect pos;
-    for(uint8_t i = 0; i < MAP_HEIGHT; i++)
+    if (snapshot->block_type >= B_MAX || snapshot->rotation >= NB_ROTATIONS || snapshot->hold >= B_MAX
+        || snapshot->queue_head >= QUEUE_SIZE || snapshot->randomizer > RANDOMIZER_BAG)
+        return false;
+    for (uint8_t i = 0; i < QUEUE_SIZE; i++)
     {
-        for(uint8_t j = 0; j < MAP_WIDTH; j++)
-        {
-            if(!board->map[i][j])
-                continue;
-
-            pos.x = (board->pos.x + board->square_size[0] * (j + 1)) + board->scale[0];
-            pos.y = (board->pos.y + board->square_size[1] * (i + 1)) + board->scale[1];
-            pos.w = board->square_size[0] - board->scale[0];
-            pos.h = board->square_size[1] - board->scale[1];
-            SDL_RenderCopy(renderer, g_squares[board->map[i][j]], NULL, &pos);
-        }
+        if (snapshot->queue[i] == B_NONE || snapshot->queue[i] >= B_MAX)
+            return false;
     }
-}
 
-
-/**
- * Draw the next tetromino in the subboard.
- * 
- * \param board the board concerned.
- * \param renderer the renderer of the window.
-*/
-void draw_next_tetromino(Board* board, SDL_Renderer* renderer)
-{
-    uint8_t correction = 0;
-    switch(board->next_tetromino->block_type) 
+    // The bag only has the bits of the block types, an empty bag is refilled at the next draw
+    if (snapshot->bag & ~(((1u << B_MAX) - 1) & ~(1u << B_NONE)))
+        return false;
+    for (uint8_t i = 0; i < GARBAGE_QUEUE_SIZE; i++)
     {
-        case T:
-        case L:
-        case J:
-        case Z:
-        case S:
-            correction = board->square_size[0] * 0.5;
-            break;
-        case I:
-        case O:
-        case B_NONE:
-        case B_MAX:
-        default:
-            break;
+        if (snapshot->garbage[i] > MAP_HEIGHT)
+            return false;
     }
 
-    SDL_Rect pos;
-    for(uint8_t i = 0; i < MINI_MAP_HEIGHT; i++)
+    // The full lines are removed when a tetromino locks, a snapshot never has one
+    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
     {
-        for(uint8_t j = 0; j < MINI_MAP_WIDTH; j++)
-        {
-            if(!board->map_next[i][j])
-                continue;
-
-            pos.x = (board->pos_subboard.x + board->square_size[0] * (j + 1)) + board->scale[0] - 1 + correction;
-            pos.y = (board->pos_subboard.y + board->square_size[1] * (i + 3)) + board->scale[1] - 1;
-            pos.w = board->square_size[0] - board->scale[0];
-            pos.h = board->square_size[1] - board->scale[1];
-            SDL_RenderCopy(renderer, g_squares[board->map_next[i][j]], NULL, &pos);
-        }
+        if ((snapshot->rows[i] & ~FULL_MASK) || snapshot->rows[i] == FULL_MASK)
+            return false;
     }
+
+    // The actual tetromino must stay inside the columns and above the last line
+    if (snapshot->block_type == B_NONE)
+        return true;
+    Tetromino tetromino = spawn_tetromino(snapshot->block_type);
+    tetromino.rotation = snapshot->rotation;
+    const PieceShape* shape = get_tetromino_shape(&tetromino);
+    const int16_t column = snapshot->x + shape->left;
+    return column >= 0 && column + shape->width <= MAP_WIDTH && snapshot->y + shape->top + shape->height <= MAP_HEIGHT;
 }
 
 
 /**
- * Draw the preview of the actual tetromino.
+ * Do a hard drop for that board.
+ * "Teleport" the actual tetromino to the preview.
  * 
  * \param board the board concerned.
- * \param renderer the renderer of the window.
 */
-void draw_preview(Board* board, SDL_Renderer* renderer) 
+void hard_drop_tetromino(Board* board) 
 {
-    if (board->actual_tetromino == NULL)
-        return;
-
-    SDL_Rect pos;
-    for(uint8_t i = 0; i < NB_SQUARES; i++)
-    {
-        pos.x = (board->pos.x + board->square_size[0] * (board->preview[i][0] + 1)) + board->scale[0];
-        pos.y = (board->pos.y + board->square_size[1] * (board->preview[i][1] + 1)) + board->scale[1];
-        pos.w = board->square_size[0] - board->scale[0];
-        pos.h = board->square_size[1] - board->scale[1];
-        SDL_RenderCopy(renderer, g_frames[board->actual_tetromino->color], NULL, &pos);
-    }
+    Tetromino* tetromino = &board->actual_tetromino;
+    int8_t distance = board->preview[0][1] - get_tetromino_square(tetromino, 0).y;
+    uint8_t score = distance * 2 * NB_SQUARES;
+    tetromino->y += distance;
+    tetromino->blocked = true;
+    board->lock_delay_passed = true;
+    board->changes |= CHANGE_MAP;
+    update_score(board, score);
 }
 
 
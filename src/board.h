@@ -3,67 +3,130 @@
 
 #define MAP_WIDTH 10
 #define MAP_HEIGHT 20
-#define MINI_MAP_WIDTH 6
-#define MINI_MAP_HEIGHT 3
-#define MAX_TETROMINOS 255
 #define TIME_UPDATE 500
 #define MAX_LEVEL 29
 #define SCORE_PER_SOFT_DROP 4
 #define MS_SECOND 1000
 #define LOCK_DELAY 500 // ms
-
-#include <SDL2/SDL.h>
+#define FULL_MASK ((1 << MAP_WIDTH) - 1) // The occupancy mask of a full line
+#define QUEUE_SIZE 5 // The number of next tetrominos known in advance
+#define GARBAGE_QUEUE_SIZE 8 // The number of batches of garbage lines waiting to be added
+#define RULES_VERSION 2 // Changes when the simulation of a board changes, the replays of other rules can't be played
 
 #include <stdbool.h>
 #include <stdint.h>
 
 #include "tetromino.h"
-#include "text.h"
+#include "rng.h"
+
+typedef enum BoardInput {
+    INPUT_NONE,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_SOFT_DROP,
+    INPUT_ROTATE,
+    INPUT_HARD_DROP,
+    INPUT_HOLD
+} BoardInput;
+
+typedef enum BoardChange {
+    CHANGE_MAP = 1,   // The map, the actual tetromino or its preview changed
+    CHANGE_NEXT = 2,  // The queue of the next tetrominos changed
+    CHANGE_STATS = 4, // The level, the score, the time or the hold changed
+    CHANGE_ALL = CHANGE_MAP | CHANGE_NEXT | CHANGE_STATS
+} BoardChange;
+
+typedef enum Randomizer {
+    RANDOMIZER_UNIFORM, // Each block type has the same chance, independently of the previous ones
+    RANDOMIZER_BAG      // The 7 block types are given in a random order, then a new bag is started
+} Randomizer;
+
+typedef struct Map {
+    uint16_t rows[MAP_HEIGHT];             // The occupancy mask of each line, the bit x is the column x
+    uint8_t colors[MAP_HEIGHT][MAP_WIDTH]; // The color of each square [line][column], only used for drawing
+} Map;
 
 typedef struct Board {
     void (*full_callback)();         // The method called when the board is full
-    void (*lines_destroyed_cb)(int); // The method called when there are lines destroyed
-    SDL_Rect pos;				     // The position of the board {x, y, w, h}
-    SDL_Rect pos_subboard;		     // The position of the subboard (left or right)
-    SDL_Rect pos_stats_board;        // The position of the stats board (left or right)
-    Tetromino* actual_tetromino;     // The actual tetromino moving
-    Tetromino* next_tetromino;       // The next tetromino
-    Tetromino** tetrominos;		     // All tetrominos in the board
-    uint8_t nb_tetrominos;		     // The number of tetrominos
-    uint8_t** map;				     // The array of array of int, it is the map [line][column]
-    uint8_t** map_next;			     // The array of array of int, for the "mini-map" of the next tetromino
+    void (*lines_destroyed_cb)(int); // The method called with the destroyed lines which did not cancel garbage
+    Tetromino actual_tetromino;      // The actual tetromino moving, its block type is B_NONE if there is none
+    uint8_t queue[QUEUE_SIZE];       // The block types of the next tetrominos, a ring buffer starting at queue_head
+    uint8_t queue_head;              // The index of the next tetromino in the queue
+    uint8_t hold;                    // The block type of the held tetromino, B_NONE if there is none
+    bool hold_used;                  // If the actual tetromino was already swapped with the hold
+    uint64_t seed;                   // The last seed given to the board
+    Rng pieces_rng;                  // The random generator of the block types
+    Rng garbage_rng;                 // The random generator of the holes in the added lines
+    Randomizer randomizer;           // The way the block types are chosen
+    uint8_t bag;                     // The block types remaining in the bag, the bit n is the block type n
+    uint8_t garbage[GARBAGE_QUEUE_SIZE]; // The numbers of lines received and not added yet, oldest first, 0 after the last batch
+    Map map;				         // The map of the board, only the locked squares
+    uint8_t heights[MAP_WIDTH];      // The line of the highest locked square of each column, MAP_HEIGHT if empty
     uint8_t** preview;			     // The preview coordinates for the actual tetromino
-    uint8_t number_of_lines_blocked; // The number of lines blocked.
-    uint8_t* holes;                  // The index of holes in a line blocked.
-    float scale[2];			         // The scale x and y factor for the size of the board
-    uint8_t square_size[2];		     // The square w and h of all squares
-    bool show_right;			     // If the next tetromino is showed on right or not
     bool full;				 	     // If the board is full or not
     bool lock_delay_passed;          // If the lock delay passed or not
     double time_clock;			     // The counter time for the clock
     double time_lock;                // The counter time for the time lock
     double time_drop;                // The counter time for the standard drop
-    Text* level_text;			     // The level text associated with the board
-    Text* score_text;                // The score text associated with the board
-    Text* time_text;                 // The time text associated with the board
     uint32_t score;			         // The score of the board
     uint16_t time;                   // The time of the board (in seconds)
     uint8_t level;                   // The level of the board
     float gravity;                   // The gravity multiplier for standard drop speed
     uint16_t lines_destroyed;        // The number of lines destroyed
     uint8_t lines_before_level_up;   // The number of lines before the level up
+    uint8_t changes;                 // The parts changed since the last draw (BoardChange), cleared by the view
+    struct Replay* replay;           // The replay recording the board, NULL if it is not recorded
 } Board;
 
-Board* create_board(SDL_Rect pos, bool show_right, void (*full_callback));
-void keyboard_event(Board* board, SDL_Keycode key);
+/* All the simulation state of a board in a fixed size blob (112 bytes), it can be copied with memcpy.
+   The colors of the map are not kept, they are only used for drawing. */
+typedef struct BoardSnapshot {
+    double time_clock, time_lock, time_drop; // The counter times of the board
+    Rng pieces_rng, garbage_rng;             // The states of the random generators
+    uint32_t score;
+    uint16_t rows[MAP_HEIGHT];               // The occupancy mask of each line
+    uint16_t time;
+    uint16_t lines_destroyed;
+    uint8_t queue[QUEUE_SIZE];
+    uint8_t queue_head;
+    uint8_t garbage[GARBAGE_QUEUE_SIZE];
+    uint8_t hold;
+    uint8_t bag;
+    uint8_t randomizer;
+    uint8_t level;
+    uint8_t lines_before_level_up;
+    uint8_t block_type, rotation;            // The actual tetromino
+    int8_t x, y;
+    uint8_t flags;                           // The booleans of the board and of the actual tetromino (SnapshotFlag)
+} BoardSnapshot;
+
+typedef enum SnapshotFlag {
+    SNAPSHOT_FULL = 1,
+    SNAPSHOT_LOCK_DELAY_PASSED = 2,
+    SNAPSHOT_HOLD_USED = 4,
+    SNAPSHOT_BLOCKED = 8
+} SnapshotFlag;
+
+Board* create_board(void (*full_callback), uint64_t seed);
+void board_input(Board* board, BoardInput input);
 void update_board(Board* board, double delta_t);
-void draw_board(Board* board, SDL_Renderer* renderer);
 void clean_board(Board** board);
 void reset_board(Board* board);
+void seed_board(Board* board, uint64_t seed);
+void set_randomizer(Board* board, Randomizer randomizer);
+BlockType get_next_block_type(const Board* board, uint8_t index);
+void board_snapshot(const Board* board, BoardSnapshot* snapshot);
+bool board_restore(Board* board, const BoardSnapshot* snapshot);
 
+void queue_garbage(Board* board, uint8_t number_of_lines);
 void add_random_lines(Board* board, uint8_t number_of_lines);
+void update_heights(Board* board);
+void get_map_heights(const Map* map, uint8_t* heights);
+void add_tetromino_to_map(Map* map, const Tetromino* tetromino);
 
-bool square_blocked(uint8_t** map, int8_t x, int8_t y, Tetromino* tetromino);
-bool tetromino_blocked(uint8_t** map, Tetromino* tetromino);
+bool tetromino_blocked(const Map* map, const Tetromino* tetromino);
+bool tetromino_collides(const Map* map, const Tetromino* tetromino, int8_t x, int8_t y);
+bool tetromino_overlaps(const Map* map, const Tetromino* tetromino, int8_t x, int8_t y);
+int8_t drop_distance(const Map* map, const uint8_t* heights, const Tetromino* tetromino);
 
 #endif // BOARD_H
@@ -0,0 +1,513 @@
+#include "board_view.h"
+
+#include "global.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/* Local functions declaration */
+void init_subboards(BoardView* view);
+bool init_texts(BoardView* view);
+void init_layers(BoardView* view, SDL_Renderer* renderer);
+SDL_Rect* get_layer_pos(BoardView* view, ViewLayer layer);
+void draw_layer(BoardView* view, SDL_Renderer* renderer, ViewLayer layer);
+
+void update_texts(BoardView* view);
+
+void draw_next_tetrominos(BoardView* view, SDL_Renderer* renderer);
+void draw_hold_tetromino(BoardView* view, SDL_Renderer* renderer);
+void draw_small_tetromino(BoardView* view, SDL_Renderer* renderer, BlockType block_type, int16_t x, int16_t y);
+void draw_map(BoardView* view, SDL_Renderer* renderer);
+void draw_actual_tetromino(BoardView* view, SDL_Renderer* renderer);
+void draw_preview(BoardView* view, SDL_Renderer* renderer);
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Create the view drawing a board.
+ *
+ * \param board the board drawn by the view.
+ * \param renderer the renderer creating the textures of the layers.
+ * \param pos the position of the board.
+ * \param show_right if the stats board and next tetrominos are showed on the right or left.
+ * \return a new board view object, NULL if it can't be created.
+*/
+BoardView* create_board_view(Board* board, SDL_Renderer* renderer, SDL_Rect pos, bool show_right)
+{
+    BoardView* view = malloc(sizeof(BoardView));
+    if (view == NULL)
+        return NULL;
+    view->board = board;
+    view->pos = pos;
+    view->show_right = show_right;
+
+    // Square size
+    view->square_size[0] = pos.w / (MAP_WIDTH + 2);  // width
+    view->square_size[1] = pos.h / (MAP_HEIGHT + 2); // height
+
+    // Scale
+    view->scale[0] = (float) pos.w / GAME_BOARD.w; // scale x
+    view->scale[1] = (float) pos.h / GAME_BOARD.h; // scale y
+
+    init_subboards(view);
+    init_layers(view, renderer);
+    if (!init_texts(view))
+    {
+        clean_board_view(&view);
+        return NULL;
+    }
+
+    return view;
+}
+
+
+/**
+ * Translate a keyboard key into a board input.
+ *
+ * \param board the board receiving the input.
+ * \param key the key pressed.
+*/
+void keyboard_event(Board* board, SDL_Keycode key)
+{
+    BoardInput input;
+    switch (key)
+    {
+        case SDLK_d:
+        case SDLK_RIGHT:
+            input = INPUT_RIGHT;
+            break;
+        case SDLK_q:
+        case SDLK_LEFT:
+            input = INPUT_LEFT;
+            break;
+        case SDLK_s:
+        case SDLK_DOWN:
+            input = INPUT_SOFT_DROP;
+            break;
+        case SDLK_r:
+            input = INPUT_ROTATE;
+            break;
+        case SDLK_SPACE:
+            input = INPUT_HARD_DROP;
+            break;
+        case SDLK_c:
+            input = INPUT_HOLD;
+            break;
+        default:
+            input = INPUT_NONE;
+            break;
+    }
+    board_input(board, input);
+}
+
+
+/**
+ * Check if the view must be drawn again.
+ *
+ * \param view the view concerned.
+ * \return true if a layer of the view changed since the last draw, false else.
+*/
+bool board_view_changed(const BoardView* view)
+{
+    return view->board->changes || view->dirty_layers;
+}
+
+
+/**
+ * Draw again all the layers of the view at the next draw,
+ * when the textures of the layers were lost.
+ *
+ * \param view the view concerned.
+*/
+void invalidate_board_view(BoardView* view)
+{
+    view->dirty_layers = (1 << NB_LAYERS) - 1;
+}
+
+
+/**
+ * Draw the board, its next tetrominos and its stats.
+ * Only the layers changed since the last draw are drawn again, the others come from their texture.
+ *
+ * \param view the view of the board to draw.
+ * \param renderer the renderer to use.
+*/
+void draw_board_view(BoardView* view, SDL_Renderer* renderer)
+{
+    // The changes of the board have the bits of the layers they concern
+    view->dirty_layers |= view->board->changes;
+    view->board->changes = 0;
+
+    for (uint8_t layer = 0; layer < NB_LAYERS; layer++)
+    {
+        if (view->layers[layer] == NULL)
+        {
+            // Without texture, the layer is drawn in the window each time
+            SDL_RenderSetViewport(renderer, get_layer_pos(view, layer));
+            draw_layer(view, renderer, layer);
+            SDL_RenderSetViewport(renderer, NULL);
+            continue;
+        }
+
+        if (view->dirty_layers & (1 << layer))
+        {
+            SDL_SetRenderTarget(renderer, view->layers[layer]);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+            SDL_RenderClear(renderer);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            draw_layer(view, renderer, layer);
+            SDL_SetRenderTarget(renderer, NULL);
+        }
+        SDL_RenderCopy(renderer, view->layers[layer], NULL, get_layer_pos(view, layer));
+    }
+    view->dirty_layers = 0;
+}
+
+
+/**
+ * Free the memory of the view, the board is not freed.
+ *
+ * \param view the view to clean.
+*/
+void clean_board_view(BoardView** view)
+{
+    if (*view == NULL)
+        return;
+
+    clean_number_text(&(*view)->level_text);
+    clean_number_text(&(*view)->score_text);
+    clean_number_text(&(*view)->time_text);
+    clean_text(&(*view)->hold_text);
+
+    for (uint8_t layer = 0; layer < NB_LAYERS; layer++)
+        if ((*view)->layers[layer] != NULL)
+            SDL_DestroyTexture((*view)->layers[layer]);
+
+    free(*view);
+    *view = NULL;
+}
+
+
+/* #################### LOCAL #################### */
+
+/**
+ * Initialize the subboards (next tetrominos and stats) of the view.
+ *
+ * \param view the view to initialize.
+*/
+void init_subboards(BoardView* view)
+{
+    // Subboard
+    if (view->show_right)
+    {
+        view->pos_subboard.x = view->pos.x + view->pos.w - view->scale[0] - view->square_size[0];
+        view->pos_subboard.y = view->pos.y;
+        view->pos_subboard.w = GAME_SUBBOARD_NEXT.w * view->scale[0];
+        view->pos_subboard.h = GAME_SUBBOARD_NEXT.h * view->scale[1];
+    }
+    else
+    {
+        view->pos_subboard.x = view->pos.x - GAME_SUBBOARD_NEXT.w * view->scale[0] + view->square_size[0] + view->scale[0];
+        view->pos_subboard.y = view->pos.y;
+        view->pos_subboard.w = GAME_SUBBOARD_NEXT.w * view->scale[0];
+        view->pos_subboard.h = GAME_SUBBOARD_NEXT.h * view->scale[1];
+    }
+
+    // Stats board
+    view->pos_stats_board.x = view->pos_subboard.x;
+    view->pos_stats_board.y = view->pos_subboard.y + view->pos_subboard.h - view->scale[0] - view->square_size[0];
+    view->pos_stats_board.w = GAME_STATS.w * view->scale[0];
+    view->pos_stats_board.h = GAME_STATS.h * view->scale[1];
+}
+
+
+/**
+ * Initialize the level, score, time and hold texts of the view.
+ * Their positions are relative to the stats board, they are drawn in its layer.
+ *
+ * \param view the view to initialize.
+ * \return false if a text can't be created, the texts created are kept for clean_board_view.
+*/
+bool init_texts(BoardView* view)
+{
+    // Level text
+    view->level_text = create_number_text(0,
+        view->pos_stats_board.w / 2 - (8 * view->scale[0]) + 0.5f * view->square_size[0],
+        view->scale[1] + view->square_size[1] * 3 - 0.5f * view->square_size[1],
+        8 * view->scale[0]
+    );
+
+    // Score text
+    view->score_text = create_number_text(0,
+        view->pos_stats_board.w / 2 - (8 * view->scale[0]) + 0.5f * view->square_size[0],
+        view->scale[1] + view->square_size[1] * 7 - 0.5f * view->square_size[1],
+        8 * view->scale[0]
+    );
+
+    // Time text
+    view->time_text = create_number_text(0,
+        view->pos_stats_board.w / 2 - (8 * view->scale[0]) + 0.5f * view->square_size[0],
+        view->scale[1] + view->square_size[1] * 11 - 0.5f * view->square_size[1],
+        8 * view->scale[0]
+    );
+
+    // Hold text, centered below the time
+    view->hold_text = create_text("HOLD", 0, view->scale[1] + view->square_size[1] * 12, 8 * view->scale[0]);
+    if (view->level_text == NULL || view->score_text == NULL || view->time_text == NULL || view->hold_text == NULL)
+        return false;
+    view->hold_text->pos.x = (view->pos_stats_board.w - view->hold_text->pos.w) / 2;
+    return true;
+}
+
+
+/**
+ * Create the textures caching the layers of the view.
+ * If the renderer can't draw in textures, the layers are drawn at each frame.
+ *
+ * \param view the view to initialize.
+ * \param renderer the renderer creating the textures.
+*/
+void init_layers(BoardView* view, SDL_Renderer* renderer)
+{
+    view->dirty_layers = (1 << NB_LAYERS) - 1;
+    SDL_RendererInfo info;
+    const bool targets = SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_TARGETTEXTURE);
+    for (uint8_t layer = 0; layer < NB_LAYERS; layer++)
+    {
+        view->layers[layer] = NULL;
+        if (!targets)
+            continue;
+        const SDL_Rect* pos = get_layer_pos(view, layer);
+        view->layers[layer] = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pos->w, pos->h);
+        if (view->layers[layer] != NULL)
+            SDL_SetTextureBlendMode(view->layers[layer], SDL_BLENDMODE_BLEND);
+    }
+}
+
+
+/**
+ * Get the position of a layer in the window.
+ *
+ * \param view the view concerned.
+ * \param layer the layer concerned.
+ * \return the position of the layer.
+*/
+SDL_Rect* get_layer_pos(BoardView* view, ViewLayer layer)
+{
+    switch (layer)
+    {
+        case LAYER_NEXT:
+            return &view->pos_subboard;
+        case LAYER_STATS:
+            return &view->pos_stats_board;
+        case LAYER_BOARD:
+        case NB_LAYERS:
+        default:
+            return &view->pos;
+    }
+}
+
+
+/**
+ * Draw the content of a layer, the positions are relative to the layer.
+ *
+ * \param view the view concerned.
+ * \param renderer the renderer to use, its target is the layer.
+ * \param layer the layer to draw.
+*/
+void draw_layer(BoardView* view, SDL_Renderer* renderer, ViewLayer layer)
+{
+    const SDL_Rect* pos = get_layer_pos(view, layer);
+    const SDL_Rect background = { 0, 0, pos->w, pos->h };
+    switch (layer)
+    {
+        case LAYER_BOARD:
+            SDL_RenderCopy(renderer, g_game_board, NULL, &background);
+            draw_preview(view, renderer);
+            draw_map(view, renderer);
+            draw_actual_tetromino(view, renderer);
+            break;
+        case LAYER_NEXT:
+            SDL_RenderCopy(renderer, g_game_subboard_next, NULL, &background);
+            draw_next_tetrominos(view, renderer);
+            break;
+        case LAYER_STATS:
+            update_texts(view);
+            SDL_RenderCopy(renderer, g_game_stats, NULL, &background);
+            draw_number_text(view->level_text, renderer);
+            draw_number_text(view->score_text, renderer);
+            draw_number_text(view->time_text, renderer);
+            draw_text(view->hold_text, renderer);
+            draw_hold_tetromino(view, renderer);
+            break;
+        case NB_LAYERS:
+        default:
+            break;
+    }
+}
+
+
+/**
+ * Update the texts of the view with the values of the board, only the changed values are formatted.
+ *
+ * \param view the view to update.
+*/
+void update_texts(BoardView* view)
+{
+    const Board* board = view->board;
+    set_number_text(view->level_text, board->level);
+    set_number_text(view->score_text, board->score);
+    set_number_text(view->time_text, board->time);
+}
+
+
+/**
+ * Draw the queue of next tetrominos in the subboard at half size, relative to the subboard.
+ * They are drawn two per line, the next one first.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+*/
+void draw_next_tetrominos(BoardView* view, SDL_Renderer* renderer)
+{
+    const float center = 0.5f * view->pos_subboard.w;
+    for (uint8_t i = 0; i < QUEUE_SIZE; i++)
+    {
+        // The last tetromino is centered when it is alone on its line
+        float column = (i % 2) ? 1.25f : -1.25f;
+        if (i == QUEUE_SIZE - 1 && !(i % 2))
+            column = 0;
+
+        int16_t x = center + column * view->square_size[0];
+        int16_t y = (2.9f + 1.3f * (i / 2)) * view->square_size[1];
+        draw_small_tetromino(view, renderer, get_next_block_type(view->board, i), x, y);
+    }
+}
+
+
+/**
+ * Draw the held tetromino at half size below the hold text, relative to the stats board.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+*/
+void draw_hold_tetromino(BoardView* view, SDL_Renderer* renderer)
+{
+    int16_t x = 0.5f * view->pos_stats_board.w;
+    int16_t y = view->scale[1] + view->square_size[1] * 14;
+    draw_small_tetromino(view, renderer, view->board->hold, x, y);
+}
+
+
+/**
+ * Draw a tetromino in its spawn rotation with squares at half size.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+ * \param block_type the block type of the tetromino, nothing is drawn for B_NONE.
+ * \param x the x of the center of the tetromino, relative to the layer.
+ * \param y the y of the center of the tetromino, relative to the layer.
+*/
+void draw_small_tetromino(BoardView* view, SDL_Renderer* renderer, BlockType block_type, int16_t x, int16_t y)
+{
+    if (block_type == B_NONE)
+        return;
+
+    const Tetromino tetromino = spawn_tetromino(block_type);
+    const PieceShape* shape = get_tetromino_shape(&tetromino);
+    const Square* cells = get_tetromino_cells(&tetromino);
+    const float size[2] = { 0.5f * view->square_size[0], 0.5f * view->square_size[1] };
+
+    SDL_Rect pos;
+    for (uint8_t i = 0; i < NB_SQUARES; i++)
+    {
+        pos.x = x + size[0] * (cells[i].x - shape->left - 0.5f * shape->width);
+        pos.y = y + size[1] * (cells[i].y - shape->top - 0.5f * shape->height);
+        pos.w = size[0] - 0.5f * view->scale[0];
+        pos.h = size[1] - 0.5f * view->scale[1];
+        SDL_RenderCopy(renderer, g_squares[tetromino.color], NULL, &pos);
+    }
+}
+
+
+/**
+ * Draw the squares of the map, relative to the board.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+*/
+void draw_map(BoardView* view, SDL_Renderer* renderer)
+{
+    const Map* map = &view->board->map;
+    SDL_Rect pos;
+    for(uint8_t i = 0; i < MAP_HEIGHT; i++)
+    {
+        if (!map->rows[i])
+            continue;
+
+        for(uint8_t j = 0; j < MAP_WIDTH; j++)
+        {
+            if(!(map->rows[i] & (1 << j)))
+                continue;
+
+            pos.x = (view->square_size[0] * (j + 1)) + view->scale[0];
+            pos.y = (view->square_size[1] * (i + 1)) + view->scale[1];
+            pos.w = view->square_size[0] - view->scale[0];
+            pos.h = view->square_size[1] - view->scale[1];
+            SDL_RenderCopy(renderer, g_squares[map->colors[i][j]], NULL, &pos);
+        }
+    }
+}
+
+
+/**
+ * Draw the squares of the actual tetromino inside the map, relative to the board.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+*/
+void draw_actual_tetromino(BoardView* view, SDL_Renderer* renderer)
+{
+    const Tetromino* tetromino = &view->board->actual_tetromino;
+    if (tetromino->block_type == B_NONE)
+        return;
+
+    SDL_Rect pos;
+    for(uint8_t i = 0; i < NB_SQUARES; i++)
+    {
+        Square square = get_tetromino_square(tetromino, i);
+        if (square.y < 0)
+            continue;
+
+        pos.x = (view->square_size[0] * (square.x + 1)) + view->scale[0];
+        pos.y = (view->square_size[1] * (square.y + 1)) + view->scale[1];
+        pos.w = view->square_size[0] - view->scale[0];
+        pos.h = view->square_size[1] - view->scale[1];
+        SDL_RenderCopy(renderer, g_squares[tetromino->color], NULL, &pos);
+    }
+}
+
+
+/**
+ * Draw the preview of the actual tetromino, relative to the board.
+ *
+ * \param view the view of the board.
+ * \param renderer the renderer to use.
+*/
+void draw_preview(BoardView* view, SDL_Renderer* renderer)
+{
+    const Board* board = view->board;
+    if (board->actual_tetromino.block_type == B_NONE)
+        return;
+
+    SDL_Rect pos;
+    for(uint8_t i = 0; i < NB_SQUARES; i++)
+    {
+        pos.x = (view->square_size[0] * (board->preview[i][0] + 1)) + view->scale[0];
+        pos.y = (view->square_size[1] * (board->preview[i][1] + 1)) + view->scale[1];
+        pos.w = view->square_size[0] - view->scale[0];
+        pos.h = view->square_size[1] - view->scale[1];
+        SDL_RenderCopy(renderer, g_frames[board->actual_tetromino.color], NULL, &pos);
+    }
+}
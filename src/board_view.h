@@ -0,0 +1,42 @@
+#ifndef BOARD_VIEW_H
+#define BOARD_VIEW_H
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "text.h"
+
+typedef enum ViewLayer {
+    LAYER_BOARD, // The board, the map and the preview, redrawn on CHANGE_MAP
+    LAYER_NEXT,  // The subboard and the queue of next tetrominos, redrawn on CHANGE_NEXT
+    LAYER_STATS, // The stats board, its texts and the hold, redrawn on CHANGE_STATS
+    NB_LAYERS
+} ViewLayer;
+
+typedef struct BoardView {
+    Board* board;                    // The board drawn by this view
+    SDL_Rect pos;				     // The position of the board {x, y, w, h}
+    SDL_Rect pos_subboard;		     // The position of the subboard (left or right)
+    SDL_Rect pos_stats_board;        // The position of the stats board (left or right)
+    float scale[2];			         // The scale x and y factor for the size of the board
+    uint8_t square_size[2];		     // The square w and h of all squares
+    bool show_right;			     // If the next tetromino is showed on right or not
+    NumberText* level_text;		     // The level text associated with the board
+    NumberText* score_text;          // The score text associated with the board
+    NumberText* time_text;           // The time text associated with the board
+    Text* hold_text;                 // The label of the held tetromino
+    SDL_Texture* layers[NB_LAYERS];  // The cached drawing of each layer, NULL if the renderer has no target textures
+    uint8_t dirty_layers;            // The layers to draw again, the bit n is the layer n
+} BoardView;
+
+BoardView* create_board_view(Board* board, SDL_Renderer* renderer, SDL_Rect pos, bool show_right);
+void keyboard_event(Board* board, SDL_Keycode key);
+bool board_view_changed(const BoardView* view);
+void invalidate_board_view(BoardView* view);
+void draw_board_view(BoardView* view, SDL_Renderer* renderer);
+void clean_board_view(BoardView** view);
+
+#endif // BOARD_VIEW_H
@@ -111,19 +111,22 @@ void check_buttons_click(Button** buttons, const uint8_t nb_buttons, const SDL_M
  *
  * \param buttons all the buttons to be checked.
  * \param nb_buttons the number of buttons.
+ * \return true if a button changed of state (so it must be drawn again), false else.
  * \see check_hover_on_button(button, int, int)
 */
-void check_buttons_hover(Button** buttons, const uint8_t nb_buttons, const SDL_MouseMotionEvent event)
+bool check_buttons_hover(Button** buttons, const uint8_t nb_buttons, const SDL_MouseMotionEvent event)
 {
     const uint16_t x = event.x;
     const uint16_t y = event.y;
     bool has_changed = false;
+    bool redraw = false;
     for (uint8_t i = 0; i < nb_buttons; i++)
     {
         Button* btn = buttons[i];
 
         if (check_mouse_on_button(btn, x, y))
         {
+            redraw |= !btn->hovered;
             btn->hovered = true;
             SDL_SetCursor(g_cursor_hovered);
             has_changed = true;
@@ -131,10 +134,13 @@ void check_buttons_hover(Button** buttons, const uint8_t nb_buttons, const SDL_M
         }
         else 
         {
+            redraw |= btn->hovered;
             btn->hovered = false;
         }
     }
 
     if (!has_changed)
         SDL_SetCursor(g_cursor_normal);
+
+    return redraw;
 }
\ No newline at end of file
@@ -23,6 +23,6 @@ void draw_button(Button* button, SDL_Renderer* renderer);
 void clean_button(Button** button);
 
 void check_buttons_click(Button** buttons, const uint8_t nb_buttons, const SDL_MouseButtonEvent event);
-void check_buttons_hover(Button** buttons, const uint8_t nb_buttons, const SDL_MouseMotionEvent event);
+bool check_buttons_hover(Button** buttons, const uint8_t nb_buttons, const SDL_MouseMotionEvent event);
 
 #endif // BUTTON_H
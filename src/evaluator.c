@@ -0,0 +1,306 @@
+#include "evaluator.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "print_color.h"
+
+#define COUNTER_BITS 5 // The bits of the counters of each column, up to MAP_HEIGHT
+#define BITS_2(n) n, n + 1, n + 1, n + 2
+#define BITS_4(n) BITS_2(n), BITS_2(n + 1), BITS_2(n + 1), BITS_2(n + 2)
+#define BITS_6(n) BITS_4(n), BITS_4(n + 1), BITS_4(n + 1), BITS_4(n + 2)
+#define BITS_8(n) BITS_6(n), BITS_6(n + 1), BITS_6(n + 1), BITS_6(n + 2)
+
+/* Evaluator functions declaration */
+uint8_t count_squares(uint16_t mask);
+void add_to_counters(uint16_t* counters, uint16_t mask);
+uint16_t sum_counters(const uint16_t* counters, uint16_t mask);
+
+/* The number of bits set in each byte */
+static const uint8_t byte_squares[256] = { BITS_8(0) };
+
+/* The names of the features in the weights files */
+static const char* feature_names[NB_FEATURES] = {
+    [FEATURE_LINES] = "lines",
+    [FEATURE_HEIGHT] = "height",
+    [FEATURE_BUMPINESS] = "bumpiness",
+    [FEATURE_ROW_TRANSITIONS] = "row_transitions",
+    [FEATURE_COLUMN_TRANSITIONS] = "column_transitions",
+    [FEATURE_WELLS] = "wells",
+    [FEATURE_HOLES] = "holes",
+    [FEATURE_HOLE_DEPTH] = "hole_depth"
+};
+
+/* The weights used when no others are given */
+static const AIWeights default_weights = { {
+    [FEATURE_LINES] = 0.8f,
+    [FEATURE_HEIGHT] = -0.5f,
+    [FEATURE_BUMPINESS] = -0.2f,
+    [FEATURE_ROW_TRANSITIONS] = -0.3f,
+    [FEATURE_COLUMN_TRANSITIONS] = -0.9f,
+    [FEATURE_WELLS] = -0.3f,
+    [FEATURE_HOLES] = -0.8f,
+    [FEATURE_HOLE_DEPTH] = -0.2f
+} };
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Get the default weights of the features.
+ *
+ * \param weights the weights filled.
+*/
+void get_default_weights(AIWeights* weights)
+{
+    *weights = default_weights;
+}
+
+
+/**
+ * Remove the full lines of a map, the lines above them go down.
+ *
+ * \param rows the occupancy masks of the lines of the map.
+ * \param cleared the occupancy masks of the lines once the full lines are removed, it can be rows.
+ * \return the number of full lines removed.
+*/
+uint8_t remove_full_rows(const uint16_t* rows, uint16_t* cleared)
+{
+    int8_t destination = MAP_HEIGHT - 1;
+    for (int8_t line = MAP_HEIGHT - 1; line >= 0; line--)
+    {
+        if (rows[line] != FULL_MASK)
+            cleared[destination--] = rows[line];
+    }
+    const uint8_t lines = destination + 1;
+    memset(cleared, 0, lines * sizeof(uint16_t));
+    return lines;
+}
+
+
+/**
+ * Compute the features of a map with only bit operations on its lines, from the top to the bottom.
+ * The depths of the wells are bit sliced counters : the bit x of counters[k] is the bit k of the depth in the column x.
+ *
+ * The lines cleared are not a feature of the map, FEATURE_LINES is 0 and the caller sets the lines of remove_full_rows.
+ *
+ * \param rows the occupancy masks of the lines of the map, without full lines.
+ * \param features the features of the map, NB_FEATURES values.
+*/
+void get_board_features(const uint16_t* rows, int16_t* features)
+{
+    // The empty lines above the stack only have the transitions with the walls
+    uint8_t top = 0;
+    while (top < MAP_HEIGHT && !rows[top])
+        top++;
+    uint16_t row_transitions = 2 * top;
+    uint16_t column_transitions = top == 0 ? 0 : top < MAP_HEIGHT ? count_squares(rows[top]) : MAP_WIDTH;
+
+    // The features are summed in locals, the features array could alias the lines
+    uint16_t height = 0, bumpiness = 0, wells_depth = 0, holes_count = 0, holes_depth = 0;
+    uint16_t covered = 0;                       // The columns with a full square above the line
+    uint16_t holes[MAP_HEIGHT];                 // The holes of each line
+    uint16_t well_depths[COUNTER_BITS] = { 0 }; // The depth of the well reaching the line in each column
+    for (uint8_t line = top; line < MAP_HEIGHT; line++)
+    {
+        const uint16_t row = rows[line];
+
+        // The empty squares under the stack are holes, deeper under more full squares
+        holes[line] = covered & ~row & FULL_MASK;
+        holes_count += count_squares(holes[line]);
+        covered |= row;
+
+        // Each column counts once for each line from its top to the floor
+        height += count_squares(covered);
+        bumpiness += count_squares((covered ^ (covered >> 1)) & (FULL_MASK >> 1));
+
+        // The walls are full on both sides
+        const uint16_t walled = row << 1 | 1 | 1 << (MAP_WIDTH + 1);
+        row_transitions += count_squares((walled ^ (walled >> 1)) & ((1 << (MAP_WIDTH + 1)) - 1));
+        const uint16_t below = line + 1 < MAP_HEIGHT ? rows[line + 1] : FULL_MASK;
+        column_transitions += count_squares(row ^ below);
+
+        // A well square is open above and has full squares or walls on both sides, its depth grows down the well
+        const uint16_t left = row << 1 | 1;
+        const uint16_t right = row >> 1 | 1 << (MAP_WIDTH - 1);
+        const uint16_t wells = ~covered & left & right & FULL_MASK;
+        for (uint8_t k = 0; k < COUNTER_BITS; k++)
+            well_depths[k] &= wells;
+        if (wells)
+        {
+            add_to_counters(well_depths, wells);
+            wells_depth += sum_counters(well_depths, wells);
+        }
+    }
+
+    // From the bottom, the full squares with a hole below them in their column
+    uint16_t holes_below = 0;
+    for (int8_t line = MAP_HEIGHT - 1; line >= top; line--)
+    {
+        holes_depth += count_squares(rows[line] & holes_below);
+        holes_below |= holes[line];
+    }
+
+    features[FEATURE_LINES] = 0;
+    features[FEATURE_HEIGHT] = height;
+    features[FEATURE_BUMPINESS] = bumpiness;
+    features[FEATURE_ROW_TRANSITIONS] = row_transitions;
+    features[FEATURE_COLUMN_TRANSITIONS] = column_transitions;
+    features[FEATURE_WELLS] = wells_depth;
+    features[FEATURE_HOLES] = holes_count;
+    features[FEATURE_HOLE_DEPTH] = holes_depth;
+}
+
+
+/**
+ * Compute the score of features with weights.
+ *
+ * \param weights the weights of the features.
+ * \param features the features, NB_FEATURES values.
+ * \return the score, higher is better.
+*/
+float evaluate_features(const AIWeights* weights, const int16_t* features)
+{
+    float score = 0;
+    for (uint8_t i = 0; i < NB_FEATURES; i++)
+        score += weights->weights[i] * features[i];
+    return score;
+}
+
+
+/**
+ * Get the path of the weights file, AI_WEIGHTS_FILE in the directory of a program.
+ * The game, headless and the tuner are built in the same directory, so they share the file from any working directory.
+ *
+ * \param program the path of the program (argv[0]), or of its directory ended by a separator.
+ * \param path the path of the weights file.
+ * \param size the size of path.
+ * \return false if the path is too long.
+*/
+bool get_weights_path(const char* program, char* path, size_t size)
+{
+    const char* separator = strrchr(program, '/');
+    const char* backslash = strrchr(program, '\\');
+    if (backslash != NULL && (separator == NULL || backslash > separator))
+        separator = backslash;
+    const size_t directory = separator != NULL ? (size_t) (separator - program + 1) : 0;
+    if (directory + sizeof(AI_WEIGHTS_FILE) > size)
+        return false;
+    memcpy(path, program, directory);
+    memcpy(path + directory, AI_WEIGHTS_FILE, sizeof(AI_WEIGHTS_FILE));
+    return true;
+}
+
+
+/**
+ * Load weights from a text file, each line is the name of a feature and its weight, like "holes -0.8".
+ * The features missing from the file keep their weight.
+ *
+ * \param path the path of the weights file.
+ * \param weights the weights read, unchanged if the file can't be read.
+ * \return false if the file can't be opened or is not a weights file.
+*/
+bool load_weights(const char* path, AIWeights* weights)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+
+    AIWeights loaded = *weights;
+    char name[32];
+    float weight;
+    bool valid = true;
+    int read;
+    while (valid && (read = fscanf(file, "%31s %f", name, &weight)) == 2)
+    {
+        uint8_t feature = 0;
+        while (feature < NB_FEATURES && strcmp(name, feature_names[feature]))
+            feature++;
+        valid = feature < NB_FEATURES;
+        if (valid)
+            loaded.weights[feature] = weight;
+    }
+    valid = valid && read == EOF;
+    fclose(file);
+
+    if (!valid)
+    {
+        print_color("The weights file is not valid, the weights are unchanged", TXT_RED);
+        return false;
+    }
+    *weights = loaded;
+    return true;
+}
+
+
+/**
+ * Save weights in a text file readable by load_weights.
+ *
+ * \param path the path of the weights file, replaced if it exists.
+ * \param weights the weights saved.
+ * \return false if the file can't be written.
+*/
+bool save_weights(const char* path, const AIWeights* weights)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        print_color("Error opening the weights file", TXT_RED);
+        return false;
+    }
+    bool written = true;
+    for (uint8_t i = 0; i < NB_FEATURES; i++)
+        written = fprintf(file, "%s %.6f\n", feature_names[i], weights->weights[i]) > 0 && written;
+    written = fclose(file) == 0 && written;
+    if (!written)
+        print_color("Error writing the weights file", TXT_RED);
+    return written;
+}
+
+
+/* #################### PRIVATE #################### */
+
+/**
+ * Count the squares of an occupancy mask.
+ *
+ * \param mask the mask concerned.
+ * \return the number of bits set.
+*/
+uint8_t count_squares(uint16_t mask)
+{
+    return byte_squares[mask & 0xFF] + byte_squares[mask >> 8];
+}
+
+
+/**
+ * Add one to the bit sliced counters of the columns of a mask.
+ *
+ * \param counters the bit sliced counters, COUNTER_BITS masks.
+ * \param mask the columns incremented.
+*/
+void add_to_counters(uint16_t* counters, uint16_t mask)
+{
+    uint16_t carry = mask;
+    for (uint8_t k = 0; k < COUNTER_BITS; k++)
+    {
+        const uint16_t next = counters[k] & carry;
+        counters[k] ^= carry;
+        carry = next;
+    }
+}
+
+
+/**
+ * Sum the bit sliced counters of the columns of a mask.
+ *
+ * \param counters the bit sliced counters, COUNTER_BITS masks.
+ * \param mask the columns summed.
+ * \return the sum of their counters.
+*/
+uint16_t sum_counters(const uint16_t* counters, uint16_t mask)
+{
+    uint16_t sum = 0;
+    for (uint8_t k = 0; k < COUNTER_BITS; k++)
+        sum += count_squares(counters[k] & mask) << k;
+    return sum;
+}
@@ -0,0 +1,38 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "board.h"
+
+#define AI_WEIGHTS_FILE "weights.txt" // The weights file written by the tuner, next to the executables
+
+/* The features of a board after a placement, computed on the occupancy masks of its lines. */
+typedef enum AIFeature {
+    FEATURE_LINES,              // The lines cleared by the sequence of placements, set by the AI from remove_full_rows
+    FEATURE_HEIGHT,             // The sum of the heights of the columns
+    FEATURE_BUMPINESS,          // The sum of the height differences between neighbour columns
+    FEATURE_ROW_TRANSITIONS,    // The changes between empty and full squares along each line, the walls are full
+    FEATURE_COLUMN_TRANSITIONS, // The changes between empty and full squares along each column, the floor is full
+    FEATURE_WELLS,              // The sum of 1 + 2 + ... + depth for each well, an open column between two full squares
+    FEATURE_HOLES,              // The empty squares with a full square above them
+    FEATURE_HOLE_DEPTH,         // The full squares above a hole of their column, they must be cleared to reach it
+    NB_FEATURES
+} AIFeature;
+
+/* The weight of each feature in the score of a board, a higher score is better. */
+typedef struct AIWeights {
+    float weights[NB_FEATURES];
+} AIWeights;
+
+void get_default_weights(AIWeights* weights);
+uint8_t remove_full_rows(const uint16_t* rows, uint16_t* cleared);
+void get_board_features(const uint16_t* rows, int16_t* features);
+float evaluate_features(const AIWeights* weights, const int16_t* features);
+bool get_weights_path(const char* program, char* path, size_t size);
+bool load_weights(const char* path, AIWeights* weights);
+bool save_weights(const char* path, const AIWeights* weights);
+
+#endif // EVALUATOR_H
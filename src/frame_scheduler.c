@@ -0,0 +1,108 @@
+#include "frame_scheduler.h"
+
+#include "board.h"
+
+#include <SDL2/SDL.h>
+
+#include <stdlib.h>
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Create a scheduler keeping the loops of the scenes at a frame rate.
+ * The scheduler sleeps until the next frame, it doesn't need the vsync.
+ *
+ * \param frame_rate the target number of frames per second.
+ * \return a new frame scheduler object.
+*/
+FrameScheduler* create_frame_scheduler(uint16_t frame_rate)
+{
+    FrameScheduler* scheduler = malloc(sizeof(FrameScheduler));
+    if (scheduler == NULL)
+        return NULL;
+    scheduler->frequency = SDL_GetPerformanceFrequency();
+    scheduler->last_frame = SDL_GetPerformanceCounter();
+    set_frame_rate(scheduler, frame_rate);
+    return scheduler;
+}
+
+
+/**
+ * Change the target frame rate of the scheduler.
+ *
+ * \param scheduler the scheduler concerned.
+ * \param frame_rate the target number of frames per second, the default one if 0.
+*/
+void set_frame_rate(FrameScheduler* scheduler, uint16_t frame_rate)
+{
+    scheduler->frame_rate = frame_rate ? frame_rate : DEFAULT_FRAME_RATE;
+    scheduler->frame_ticks = scheduler->frequency / scheduler->frame_rate;
+    scheduler->next_deadline = SDL_GetPerformanceCounter() + scheduler->frame_ticks;
+}
+
+
+/**
+ * Start a new frame.
+ *
+ * \param scheduler the scheduler concerned.
+ * \return the time passed since the start of the last frame (in ms), at most MAX_FRAME_TIME.
+*/
+double begin_frame(FrameScheduler* scheduler)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    double delta_t = (double) (now - scheduler->last_frame) * MS_SECOND / scheduler->frequency;
+    scheduler->last_frame = now;
+    return delta_t < MAX_FRAME_TIME ? delta_t : MAX_FRAME_TIME;
+}
+
+
+/**
+ * End the frame, wait until the next one.
+ * When the scene is idle (paused or static), nothing changes without an event,
+ * so the scheduler sleeps until the next event instead of the next frame.
+ *
+ * \param scheduler the scheduler concerned.
+ * \param idle if the scene has nothing to update until the next event.
+*/
+void end_frame(FrameScheduler* scheduler, bool idle)
+{
+    if (idle)
+    {
+        // The event is not removed from the queue, the scene handles it in the next frame
+        SDL_WaitEvent(NULL);
+
+        // The time waited is not given to the updates
+        scheduler->last_frame = SDL_GetPerformanceCounter();
+        scheduler->next_deadline = scheduler->last_frame + scheduler->frame_ticks;
+        return;
+    }
+
+    uint64_t now = SDL_GetPerformanceCounter();
+    if (now < scheduler->next_deadline)
+    {
+        uint32_t wait = (scheduler->next_deadline - now) * MS_SECOND / scheduler->frequency;
+        if (wait > 0)
+            SDL_Delay(wait);
+        scheduler->next_deadline += scheduler->frame_ticks;
+    }
+    else
+    {
+        // Too late (or blocked by the vsync), the next frame starts from now
+        scheduler->next_deadline = now + scheduler->frame_ticks;
+    }
+}
+
+
+/**
+ * Free the memory of the scheduler.
+ *
+ * \param scheduler the scheduler to clean.
+*/
+void clean_frame_scheduler(FrameScheduler** scheduler)
+{
+    if (*scheduler == NULL)
+        return;
+    free(*scheduler);
+    *scheduler = NULL;
+}
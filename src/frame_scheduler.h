@@ -0,0 +1,24 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#define DEFAULT_FRAME_RATE 60 // The number of frames per second by default
+#define MAX_FRAME_TIME 100    // The maximum time of a frame given to the updates (ms)
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct FrameScheduler {
+    uint64_t frequency;     // The number of performance counter ticks per second
+    uint64_t frame_ticks;   // The duration of a frame (ticks)
+    uint64_t next_deadline; // The time when the next frame should start (ticks)
+    uint64_t last_frame;    // The time when the last frame started (ticks)
+    uint16_t frame_rate;    // The target number of frames per second
+} FrameScheduler;
+
+FrameScheduler* create_frame_scheduler(uint16_t frame_rate);
+void set_frame_rate(FrameScheduler* scheduler, uint16_t frame_rate);
+double begin_frame(FrameScheduler* scheduler);
+void end_frame(FrameScheduler* scheduler, bool idle);
+void clean_frame_scheduler(FrameScheduler** scheduler);
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,167 @@
+#include "board.h"
+#include "ai.h"
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HEADLESS_DELTA_T 16     // The fixed time step of a frame (ms)
+#define HEADLESS_MAX_FRAMES 2000000 // The number of frames before a game is stopped
+
+static bool headless_full = false;
+static AIWeights headless_weights; // The weights of the AI, from the weights file if it exists
+
+void headless_full_callback();
+void run_game(uint32_t seed, AIDifficulty difficulty, Randomizer randomizer, uint8_t beam_width, uint8_t beam_depth,
+    ThreadPool* pool, const char* replay_path);
+int run_replay(const char* path, uint32_t updates);
+
+/**
+ * Run AI games without window as fast as possible, with the weights of AI_WEIGHTS_FILE next to headless if it exists.
+ * usage : headless [number of games] [first seed] [uniform|bag] [beam width] [beam depth] [number of threads]
+ *         headless record <replay file> [seed] [uniform|bag]
+ *         headless replay <replay file> [number of updates]
+*/
+int main(int argc, char** argv)
+{
+    char weights_path[FILENAME_MAX];
+    get_default_weights(&headless_weights);
+    if (get_weights_path(argv[0], weights_path, sizeof(weights_path)) && load_weights(weights_path, &headless_weights))
+        printf("weights loaded from %s\n", weights_path);
+    else
+        printf("default weights, no weights file in the directory of headless\n");
+
+    if (argc > 2 && !strcmp(argv[1], "record"))
+    {
+        const uint32_t seed = argc > 3 ? (uint32_t) atoi(argv[3]) : 1;
+        const Randomizer randomizer = argc > 4 && !strcmp(argv[4], "bag") ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+        run_game(seed, EXTREME, randomizer, AI_BEAM_WIDTH, AI_BEAM_DEPTH, NULL, argv[2]);
+        return 0;
+    }
+    if (argc > 2 && !strcmp(argv[1], "replay"))
+        return run_replay(argv[2], argc > 3 ? (uint32_t) atoi(argv[3]) : UINT32_MAX);
+
+    const uint32_t nb_games = argc > 1 ? (uint32_t) atoi(argv[1]) : 1;
+    const uint32_t seed = argc > 2 ? (uint32_t) atoi(argv[2]) : 1;
+    const Randomizer randomizer = argc > 3 && !strcmp(argv[3], "bag") ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+    const uint8_t beam_width = argc > 4 ? (uint8_t) atoi(argv[4]) : AI_BEAM_WIDTH;
+    const uint8_t beam_depth = argc > 5 ? (uint8_t) atoi(argv[5]) : AI_BEAM_DEPTH;
+    const uint8_t nb_threads = argc > 6 ? (uint8_t) atoi(argv[6]) : 1;
+    ThreadPool* pool = nb_threads > 1 ? create_thread_pool(nb_threads) : NULL;
+
+    // The time of the clock, the processor time would add the time of every thread
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+    for (uint32_t i = 0; i < nb_games; i++)
+        run_game(seed + i, EXTREME, randomizer, beam_width, beam_depth, pool, NULL);
+    timespec_get(&end, TIME_UTC);
+    double seconds = (double) (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (pool != NULL)
+        clean_thread_pool(&pool);
+
+    printf("%u games in %.3f s (%.1f games/s)\n", nb_games, seconds, seconds > 0 ? nb_games / seconds : 0);
+    return 0;
+}
+
+
+/**
+ * Callback method called when the board is full.
+*/
+void headless_full_callback()
+{
+    headless_full = true;
+}
+
+
+/**
+ * Run a game of the AI until its board is full.
+ *
+ * \param seed the seed of the random generator.
+ * \param difficulty the difficulty of the AI.
+ * \param randomizer the way the block types are chosen.
+ * \param beam_width the number of boards kept by the lookahead of the AI.
+ * \param beam_depth the number of tetrominos placed by the lookahead of the AI.
+ * \param pool the thread pool of the AI, NULL to only use the calling thread.
+ * \param replay_path the file where the game is recorded, NULL to not record it.
+*/
+void run_game(uint32_t seed, AIDifficulty difficulty, Randomizer randomizer, uint8_t beam_width, uint8_t beam_depth,
+    ThreadPool* pool, const char* replay_path)
+{
+    headless_full = false;
+
+    Board* board = create_board(&headless_full_callback, seed);
+    AI* ai = board != NULL ? create_ai(board) : NULL;
+    if (ai == NULL)
+    {
+        printf("seed %u : error creating the game\n", seed);
+        if (board != NULL)
+            clean_board(&board);
+        return;
+    }
+    set_ai_difficulty(ai, difficulty);
+    set_ai_lookahead(ai, beam_width, beam_depth);
+    set_ai_weights(ai, &headless_weights);
+    set_ai_thread_pool(ai, pool);
+    if (randomizer != RANDOMIZER_UNIFORM)
+    {
+        set_randomizer(board, randomizer);
+        seed_board(board, seed);
+    }
+    Replay* replay = NULL;
+    if (replay_path != NULL && (replay = create_replay(board, replay_path)) == NULL)
+        printf("seed %u : error creating the replay\n", seed);
+
+    uint32_t frames = 0;
+    while (!headless_full && frames < HEADLESS_MAX_FRAMES)
+    {
+        update_board(board, HEADLESS_DELTA_T);
+        ai_process(ai, HEADLESS_DELTA_T);
+        frames++;
+    }
+    printf("seed %u frames %u score %u lines %u level %u\n", seed, frames, board->score, board->lines_destroyed, board->level);
+
+    if (replay != NULL)
+        clean_replay(&replay);
+    clean_ai(&ai);
+    clean_board(&board);
+}
+
+
+/**
+ * Simulate a replay file without window as fast as possible.
+ *
+ * \param path the path of the replay file.
+ * \param updates the number of updates simulated, UINT32_MAX for the whole replay.
+ * \return the exit code, 1 if the replay can't be played.
+*/
+int run_replay(const char* path, uint32_t updates)
+{
+    headless_full = false;
+
+    ReplayView* view = create_replay_view(path);
+    if (view == NULL)
+        return 1;
+    Board* board = create_board(&headless_full_callback, 0);
+    if (board == NULL)
+    {
+        printf("error creating the board\n");
+        clean_replay_view(&view);
+        return 1;
+    }
+    if (view->index == NULL)
+        printf("the replay is incomplete, it is played until its last record\n");
+
+    clock_t start = clock();
+    uint32_t board_updates = seek_replay(view, board, updates);
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    printf("seed %llu updates %u/%u time %u score %u lines %u level %u full %d\n", (unsigned long long) board->seed,
+        board_updates, view->updates, board->time, board->score, board->lines_destroyed, board->level, headless_full);
+    printf("%u keyframes, simulated in %.3f s\n", view->nb_keyframes, seconds);
+
+    clean_board(&board);
+    clean_replay_view(&view);
+    return 0;
+}
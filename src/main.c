@@ -1,9 +1,15 @@
 #include "tetris.h"
 
-//int main(int argc, char **argv) 
-int main()
+#include <stdlib.h>
+
+/**
+ * usage : main [frames per second] [replay file]
+*/
+int main(int argc, char** argv)
 {
-    Tetris* tetris = create_game();
+    uint16_t frame_rate = argc > 1 ? (uint16_t) atoi(argv[1]) : DEFAULT_FRAME_RATE;
+    const char* replay_path = argc > 2 ? argv[2] : NULL;
+    Tetris* tetris = create_game(frame_rate, replay_path);
     if (!tetris)
         return 1;
 
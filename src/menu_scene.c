@@ -15,6 +15,7 @@ const uint16_t btn_height = 75;
 const uint16_t btn_space = 100;
 uint16_t btn_x_start = 0;
 uint16_t btn_y_start = 0;
+bool ms_redraw = true;
 
 
 /* MenuScene functions declaration */
@@ -38,8 +39,11 @@ void ms_exit_callback() { menu_scene->return_code = T_EXIT; }
 
 /**
  * Create the menu scene of the game.
+ *
+ * \param window the main window.
+ * \param scheduler the scheduler of the frames of the game.
 */
-MenuScene* create_menu_scene(SDL_Window* window) 
+MenuScene* create_menu_scene(SDL_Window* window, FrameScheduler* scheduler)
 {
     MenuScene* _menu_scene = malloc(sizeof(MenuScene));
     if (_menu_scene == NULL)
@@ -53,6 +57,7 @@ MenuScene* create_menu_scene(SDL_Window* window)
     _menu_scene->return_code = 0;
     _menu_scene->window = window;
     _menu_scene->renderer = SDL_GetRenderer(window);
+    _menu_scene->scheduler = scheduler;
     _menu_scene->ms_init = &ms_init;
     _menu_scene->ms_loop = &ms_loop;
     _menu_scene->ms_clean = &ms_clean;
@@ -92,11 +97,17 @@ bool ms_init()
 uint8_t ms_loop() 
 {
     print_color("Menu Scene loop", TXT_BLUE);
+    ms_redraw = true;
     while(!menu_scene->return_code)
     {
+        begin_frame(menu_scene->scheduler);
+
         ms_event();
         ms_update();
         ms_draw();
+
+        // The menu only changes with the events
+        end_frame(menu_scene->scheduler, true);
     }
     print_color("End Menu Scene loop", TXT_BLUE);
     return menu_scene->return_code;
@@ -120,7 +131,12 @@ void ms_event()
                 check_buttons_click(menu_scene->buttons, menu_scene->nb_buttons, event.button);
                 break;
             case SDL_MOUSEMOTION:
-                check_buttons_hover(menu_scene->buttons, menu_scene->nb_buttons, event.motion);
+                ms_redraw |= check_buttons_hover(menu_scene->buttons, menu_scene->nb_buttons, event.motion);
+                break;
+            case SDL_WINDOWEVENT:
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                ms_redraw = true;
                 break;
             default: 
                 break;
@@ -143,6 +159,11 @@ void ms_update()
 */
 void ms_draw() 
 {
+    // Nothing changed, the window keeps the last frame
+    if (!ms_redraw)
+        return;
+    ms_redraw = false;
+
     SDL_UpdateWindowSurface(menu_scene->window);
     SDL_RenderClear(menu_scene->renderer);
 
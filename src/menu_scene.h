@@ -10,18 +10,20 @@
 #include <stdbool.h>
 
 #include "button.h"
+#include "frame_scheduler.h"
 
 typedef struct MenuScene {
     Button** buttons;
     uint8_t nb_buttons;
     SDL_Window* window;
     SDL_Renderer* renderer;
+    FrameScheduler* scheduler;
     bool (*ms_init)();
     uint8_t (*ms_loop)();
     void (*ms_clean)();
     uint8_t return_code;
 } MenuScene;
 
-MenuScene* create_menu_scene(SDL_Window* window);
+MenuScene* create_menu_scene(SDL_Window* window, FrameScheduler* scheduler);
 
 #endif // MENU_SCENE_H
@@ -0,0 +1,236 @@
+#include "moves.h"
+
+#include <string.h>
+
+/* Moves functions declaration */
+uint16_t get_state_index(const Tetromino* tetromino);
+Tetromino get_state_tetromino(const MoveSearch* search, uint16_t state);
+uint64_t get_placement_key(const Tetromino* tetromino);
+bool add_placement_key(uint64_t* keys, uint64_t key);
+
+/* The inputs tried from each state, the moves at the top are found before the drops */
+static const BoardInput search_inputs[] = { INPUT_LEFT, INPUT_RIGHT, INPUT_ROTATE, INPUT_SOFT_DROP };
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Search all the positions reachable by a tetromino with the inputs of the board, breadth first,
+ * and keep each different final position once, with the shortest path to it.
+ * The gravity is not used, the tetromino only goes down with soft drops.
+ *
+ * \param search the search filled, no memory is allocated.
+ * \param map the map of the board, only with the locked squares.
+ * \param heights the height of each column of the map.
+ * \param start the tetromino at the start.
+*/
+void search_moves(MoveSearch* search, const Map* map, const uint8_t* heights, const Tetromino* start)
+{
+    uint64_t keys[PLACEMENT_KEYS_SIZE];
+    search->start = *start;
+    search->nb_placements = 0;
+    memset(search->distances, UINT8_MAX, sizeof(search->distances));
+    memset(keys, 0, sizeof(keys));
+
+    uint16_t start_state = get_state_index(start);
+    if (start_state == MOVES_NO_STATE || tetromino_collides(map, start, 0, 0))
+        return;
+    search->parents[start_state] = MOVES_NO_STATE;
+    search->distances[start_state] = 0;
+    search->queue[0] = start_state;
+    uint16_t queue_start = 0;
+    uint16_t queue_end = 1;
+
+    while (queue_start < queue_end)
+    {
+        const uint16_t state = search->queue[queue_start++];
+        const uint8_t distance = search->distances[state];
+        const Tetromino tetromino = get_state_tetromino(search, state);
+
+        // The final position of a hard drop from this state, already found from the state above if it was closer
+        const uint16_t above = state >= MOVES_WIDTH && tetromino.y > MOVES_MIN_Y ? state - MOVES_WIDTH : MOVES_NO_STATE;
+        const bool found_above = above != MOVES_NO_STATE && search->distances[above] < distance;
+        if (!found_above && distance + 1 <= MAX_PATH_LENGTH && search->nb_placements < MAX_PLACEMENTS)
+        {
+            Tetromino landing = tetromino;
+            landing.y += drop_distance(map, heights, &landing);
+            if (add_placement_key(keys, get_placement_key(&landing)))
+            {
+                Placement* placement = &search->placements[search->nb_placements++];
+                placement->tetromino = landing;
+                placement->state = state;
+                placement->path_length = distance + 1;
+            }
+        }
+
+        if (distance + 1 >= UINT8_MAX)
+            continue;
+        for (uint8_t i = 0; i < sizeof(search_inputs) / sizeof(search_inputs[0]); i++)
+        {
+            Tetromino moved = tetromino;
+            if (!move_by_input(map, &moved, search_inputs[i]))
+                continue;
+            const uint16_t next = get_state_index(&moved);
+            if (next == MOVES_NO_STATE || search->distances[next] != UINT8_MAX)
+                continue;
+            search->parents[next] = state;
+            search->inputs[next] = search_inputs[i];
+            search->distances[next] = distance + 1;
+            search->queue[queue_end++] = next;
+        }
+    }
+}
+
+
+/**
+ * Get the shortest path of inputs to a placement, from the start of the search.
+ *
+ * \param search the search done.
+ * \param placement the index of the placement.
+ * \param path the inputs of the path, ended by the hard drop, at least MAX_PATH_LENGTH long.
+ * \param states the tetromino before each input, at least MAX_PATH_LENGTH long, can be NULL.
+ * \return the number of inputs of the path.
+*/
+uint8_t get_placement_path(const MoveSearch* search, uint16_t placement, BoardInput* path, Tetromino* states)
+{
+    const uint16_t last_state = search->placements[placement].state;
+    const uint8_t length = search->placements[placement].path_length;
+
+    // The path is read backward from the last state
+    path[length - 1] = INPUT_HARD_DROP;
+    if (states != NULL)
+        states[length - 1] = get_state_tetromino(search, last_state);
+    uint16_t state = last_state;
+    for (int8_t i = length - 2; i >= 0; i--)
+    {
+        path[i] = search->inputs[state];
+        state = search->parents[state];
+        if (states != NULL)
+            states[i] = get_state_tetromino(search, state);
+    }
+    return length;
+}
+
+
+/**
+ * Move a tetromino like an input of the board would.
+ *
+ * \param map the map of the board.
+ * \param tetromino the tetromino moved.
+ * \param input the input, a move, a soft drop or a rotation.
+ * \return false if the tetromino can't move.
+*/
+bool move_by_input(const Map* map, Tetromino* tetromino, BoardInput input)
+{
+    switch (input)
+    {
+        case INPUT_LEFT:
+        case INPUT_RIGHT:
+        {
+            const int8_t x = input == INPUT_LEFT ? -1 : 1;
+            if (tetromino_collides(map, tetromino, x, 0))
+                return false;
+            tetromino->x += x;
+            return true;
+        }
+        case INPUT_SOFT_DROP:
+            // Like the board, the tetromino must not be blocked once moved
+            if (tetromino_collides(map, tetromino, 0, 2))
+                return false;
+            tetromino->y++;
+            return true;
+        case INPUT_ROTATE:
+        {
+            const Square* kicks = get_rotation_kicks(tetromino);
+            Tetromino rotated = *tetromino;
+            update_rotation(&rotated);
+            for (uint8_t i = 0; i < NB_KICKS; i++)
+            {
+                if (tetromino_collides(map, &rotated, kicks[i].x, kicks[i].y))
+                    continue;
+                rotated.x += kicks[i].x;
+                rotated.y += kicks[i].y;
+                *tetromino = rotated;
+                return true;
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+}
+
+
+/* #################### PRIVATE #################### */
+
+/**
+ * Get the index of the state of a tetromino.
+ *
+ * \param tetromino the tetromino concerned.
+ * \return the index of its state, MOVES_NO_STATE if it is out of the states.
+*/
+uint16_t get_state_index(const Tetromino* tetromino)
+{
+    const int16_t x = tetromino->x - MOVES_MIN_X;
+    const int16_t y = tetromino->y - MOVES_MIN_Y;
+    if (x < 0 || x >= MOVES_WIDTH || y < 0 || y >= MOVES_HEIGHT)
+        return MOVES_NO_STATE;
+    return (tetromino->rotation * MOVES_HEIGHT + y) * MOVES_WIDTH + x;
+}
+
+
+/**
+ * Get the tetromino of a state of the search.
+ *
+ * \param search the search concerned.
+ * \param state the index of the state.
+ * \return the tetromino in this state.
+*/
+Tetromino get_state_tetromino(const MoveSearch* search, uint16_t state)
+{
+    Tetromino tetromino = search->start;
+    tetromino.blocked = false;
+    tetromino.x = state % MOVES_WIDTH + MOVES_MIN_X;
+    tetromino.y = (state / MOVES_WIDTH) % MOVES_HEIGHT + MOVES_MIN_Y;
+    tetromino.rotation = state / (MOVES_WIDTH * MOVES_HEIGHT);
+    return tetromino;
+}
+
+
+/**
+ * Get a key identifying the squares covered by a tetromino.
+ * Two rotations covering the same squares get the same key.
+ *
+ * \param tetromino the tetromino concerned, inside the columns.
+ * \return the key, its top line and the masks of its lines.
+*/
+uint64_t get_placement_key(const Tetromino* tetromino)
+{
+    const PieceShape* shape = get_tetromino_shape(tetromino);
+    const int8_t column = tetromino->x + shape->left;
+    uint64_t key = (uint64_t) (uint8_t) (tetromino->y + shape->top) << 40;
+    for (uint8_t i = 0; i < shape->height; i++)
+        key |= (uint64_t) (shape->rows[i] << column) << (MAP_WIDTH * i);
+    return key;
+}
+
+
+/**
+ * Add the key of a placement to the hash set of the keys found.
+ *
+ * \param keys the hash set, PLACEMENT_KEYS_SIZE keys, 0 for an empty slot.
+ * \param key the key of the placement, never 0.
+ * \return false if the key was already in the set.
+*/
+bool add_placement_key(uint64_t* keys, uint64_t key)
+{
+    uint16_t slot = (key * 0x9E3779B97F4A7C15ULL) >> 54;
+    while (keys[slot])
+    {
+        if (keys[slot] == key)
+            return false;
+        slot = (slot + 1) % PLACEMENT_KEYS_SIZE;
+    }
+    keys[slot] = key;
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef MOVES_H
+#define MOVES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board.h"
+#include "tetromino.h"
+
+#define MOVES_MIN_X (-3)                // The lowest origin x of a tetromino inside the columns
+#define MOVES_MIN_Y (SPAWN_Y - 3)       // The lowest origin y of a tetromino, above the spawn with the kicks
+#define MOVES_WIDTH (MAP_WIDTH - MOVES_MIN_X)
+#define MOVES_HEIGHT (MAP_HEIGHT - MOVES_MIN_Y)
+#define MOVES_NB_STATES (MOVES_WIDTH * MOVES_HEIGHT * NB_ROTATIONS)
+#define MOVES_NO_STATE UINT16_MAX
+#define MAX_PLACEMENTS 256              // The placements found after are ignored
+#define MAX_PATH_LENGTH 48              // The longest path kept, hard drop included
+#define PLACEMENT_KEYS_SIZE 1024        // The size of the hash set of the placements found, more than MAX_PLACEMENTS
+
+/* A final position of a tetromino, reached by a hard drop. */
+typedef struct Placement {
+    Tetromino tetromino;  // The tetromino at its landing position
+    uint16_t state;       // The state of the tetromino when it is hard dropped
+    uint8_t path_length;  // The number of inputs of the shortest path, hard drop included
+} Placement;
+
+/* The states reachable by a tetromino with the inputs of the board, searched breadth first.
+   A state is a position (x, y, rotation) of the tetromino. */
+typedef struct MoveSearch {
+    Tetromino start;                          // The tetromino at the start of the search
+    uint16_t parents[MOVES_NB_STATES];        // The previous state of the shortest path, MOVES_NO_STATE for the start
+    uint8_t inputs[MOVES_NB_STATES];          // The input (BoardInput) going from the previous state
+    uint8_t distances[MOVES_NB_STATES];       // The number of inputs from the start, UINT8_MAX if not reached
+    uint16_t queue[MOVES_NB_STATES];          // The states to visit
+    Placement placements[MAX_PLACEMENTS];     // The different final positions, the shortest paths first
+    uint16_t nb_placements;
+} MoveSearch;
+
+void search_moves(MoveSearch* search, const Map* map, const uint8_t* heights, const Tetromino* start);
+uint8_t get_placement_path(const MoveSearch* search, uint16_t placement, BoardInput* path, Tetromino* states);
+bool move_by_input(const Map* map, Tetromino* tetromino, BoardInput input);
+
+#endif // MOVES_H
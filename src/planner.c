@@ -0,0 +1,180 @@
+#include "planner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "threads.h"
+#include "print_color.h"
+
+struct AIPlanner {
+    AI* ai;                  // The AI searching on the copy of the board, with the thread pool
+    Board board;             // The copy of the board searched
+    Board request;           // The copy of the board of the last request
+    uint8_t beam_width;      // The lookahead of the last request
+    uint8_t beam_depth;
+    AIWeights weights;       // The weights of the last request
+    uint32_t requested;      // The number of the last request
+    uint32_t planned;        // The number of the last request searched
+    AIPlan plans[2];         // The plan published and the plan written
+    uint8_t front;           // The index of the plan published
+    bool published;          // If the plan published answers the last request and was not taken
+    bool stop;               // If the thread must stop
+    Thread thread;
+    Mutex mutex;             // Protects the request and the plan published
+    Condition wake;          // Signaled when there is a request or when the planner stops
+};
+
+/* Planner functions declaration */
+THREAD_FUNCTION(run_planner, data);
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Create a planner and start its thread.
+ *
+ * \param pool the thread pool of the searches, NULL to only use the thread of the planner.
+ * \return the planner, NULL if it can't be created.
+*/
+AIPlanner* create_ai_planner(ThreadPool* pool)
+{
+    AIPlanner* planner = malloc(sizeof(AIPlanner));
+    if (planner == NULL)
+        return NULL;
+    memset(planner, 0, sizeof(AIPlanner));
+    planner->ai = create_ai(&planner->board);
+    if (planner->ai == NULL)
+    {
+        free(planner);
+        return NULL;
+    }
+    set_ai_thread_pool(planner->ai, pool);
+
+    init_mutex(&planner->mutex);
+    init_condition(&planner->wake);
+    if (!start_thread(&planner->thread, &run_planner, planner))
+    {
+        print_color("Error starting the thread of the planner", TXT_RED);
+        destroy_condition(&planner->wake);
+        destroy_mutex(&planner->mutex);
+        clean_ai(&planner->ai);
+        free(planner);
+        return NULL;
+    }
+    return planner;
+}
+
+
+/**
+ * Stop the thread and free a planner, the search running is finished first.
+ *
+ * \param planner the pointer of pointer of the planner.
+*/
+void clean_ai_planner(AIPlanner** planner)
+{
+    AIPlanner* _planner = *planner;
+    lock_mutex(&_planner->mutex);
+    _planner->stop = true;
+    signal_condition(&_planner->wake);
+    unlock_mutex(&_planner->mutex);
+    join_thread(_planner->thread);
+
+    destroy_condition(&_planner->wake);
+    destroy_mutex(&_planner->mutex);
+    clean_ai(&_planner->ai);
+    free(_planner);
+    *planner = NULL;
+}
+
+
+/**
+ * Ask for the path of an AI from the actual state of its board, the previous requests are forgotten.
+ * The board is copied, it can change while the path is searched.
+ *
+ * \param planner the planner concerned.
+ * \param ai the AI, with its board, its lookahead and its weights.
+*/
+void request_ai_plan(AIPlanner* planner, const AI* ai)
+{
+    lock_mutex(&planner->mutex);
+    planner->request = *ai->ai_board;
+    planner->request.preview = NULL;
+    planner->request.replay = NULL;
+    planner->beam_width = ai->beam_width;
+    planner->beam_depth = ai->beam_depth;
+    planner->weights = ai->weights;
+    planner->requested++;
+    planner->published = false;
+    signal_condition(&planner->wake);
+    unlock_mutex(&planner->mutex);
+}
+
+
+/**
+ * Take the plan of the last request if it is ready, without waiting.
+ *
+ * \param planner the planner concerned.
+ * \param plan the plan taken.
+ * \return false if the plan is not ready, or if the planner is busy publishing it.
+*/
+bool take_ai_plan(AIPlanner* planner, AIPlan* plan)
+{
+    if (!try_lock_mutex(&planner->mutex))
+        return false;
+    const bool ready = planner->published;
+    if (ready)
+    {
+        *plan = planner->plans[planner->front];
+        planner->published = false;
+    }
+    unlock_mutex(&planner->mutex);
+    return ready;
+}
+
+
+/* #################### PRIVATE #################### */
+
+/**
+ * The loop of the thread of the planner, it searches the path of each request until the planner stops.
+ * A plan is only published if no other request came during its search.
+ *
+ * \param data the planner.
+ * \return nothing.
+*/
+THREAD_FUNCTION(run_planner, data)
+{
+    AIPlanner* planner = data;
+    AI* ai = planner->ai;
+
+    lock_mutex(&planner->mutex);
+    while (true)
+    {
+        while (!planner->stop && planner->planned == planner->requested)
+            wait_condition(&planner->wake, &planner->mutex);
+        if (planner->stop)
+            break;
+        const uint32_t request = planner->requested;
+        planner->board = planner->request;
+        set_ai_lookahead(ai, planner->beam_width, planner->beam_depth);
+        set_ai_weights(ai, &planner->weights);
+        unlock_mutex(&planner->mutex);
+
+        // Only this thread changes the front plan, the back one is written without the lock
+        calculate_best_path(ai);
+        AIPlan* plan = &planner->plans[1 - planner->front];
+        memcpy(plan->actions, ai->actions, ai->size_actions * sizeof(AIAction));
+        memcpy(plan->expected, ai->expected, ai->size_actions * sizeof(Tetromino));
+        plan->target = ai->target;
+        plan->size_actions = ai->size_actions;
+
+        lock_mutex(&planner->mutex);
+        planner->planned = request;
+        if (request == planner->requested)
+        {
+            planner->front = 1 - planner->front;
+            planner->published = true;
+        }
+    }
+    unlock_mutex(&planner->mutex);
+    return 0;
+}
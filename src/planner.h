@@ -0,0 +1,29 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ai.h"
+#include "board.h"
+#include "thread_pool.h"
+
+/* A path of the AI found by the planner. */
+typedef struct AIPlan {
+    AIAction actions[AI_MAX_ACTIONS];   // The actions of the path
+    Tetromino expected[AI_MAX_ACTIONS]; // The tetromino expected before each action
+    Tetromino target;                   // The final position of the tetromino played, B_NONE if it is unknown
+    uint8_t size_actions;               // The number of actions
+} AIPlan;
+
+/* A thread searching the paths of an AI on copies of its board, so the frames never wait for a search.
+   The plans are double buffered : one is published while the next one is written.
+   The platform thread is hidden in planner.c. */
+typedef struct AIPlanner AIPlanner;
+
+AIPlanner* create_ai_planner(ThreadPool* pool);
+void clean_ai_planner(AIPlanner** planner);
+void request_ai_plan(AIPlanner* planner, const AI* ai);
+bool take_ai_plan(AIPlanner* planner, AIPlan* plan);
+
+#endif // PLANNER_H
@@ -0,0 +1,599 @@
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "print_color.h"
+
+#define REPLAY_RECORD_SIZE 5      // The kind and the number of updates of a record, before its data
+#define REPLAY_KEYFRAME_SIZE 12   // The offset and the number of updates of a keyframe in the index
+#define REPLAY_INDEX_END_SIZE 12  // The number of keyframes, the number of updates and the magic of the index
+
+/* Replay functions declaration */
+void write_data(Replay* replay, const void* data, size_t size);
+void write_record(Replay* replay, ReplayRecord kind, const void* data, size_t size);
+void write_keyframe(Replay* replay);
+void write_index(Replay* replay);
+bool read_header(ReplayView* view);
+void read_index(ReplayView* view);
+size_t record_data_size(uint8_t kind);
+bool map_file(ReplayView* view, const char* path);
+void unmap_file(ReplayView* view);
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Create a replay and start recording the board in a file.
+ * The file starts with the actual state of the board, so the recording can start at any time.
+ *
+ * \param board the board to be recorded.
+ * \param path the path of the file written, it is replaced if it exists.
+ * \return a new pointer of replay, NULL if the file can't be written.
+*/
+Replay* create_replay(Board* board, const char* path)
+{
+    Replay* replay = malloc(sizeof(Replay));
+    if (replay == NULL)
+        return NULL;
+    replay->file = fopen(path, "wb");
+    if (replay->file == NULL)
+    {
+        print_color("Error opening the replay file", TXT_RED);
+        free(replay);
+        return NULL;
+    }
+    replay->board = board;
+    replay->size = 0;
+    replay->updates = 0;
+    replay->delta_t = -1;
+    replay->pieces = 0;
+    replay->keyframe_needed = false;
+    replay->keyframes = NULL;
+    replay->nb_keyframes = 0;
+    replay->size_keyframes = 0;
+    replay->write_error = false;
+
+    const uint16_t version = REPLAY_VERSION;
+    const uint16_t rules_version = RULES_VERSION;
+    BoardSnapshot snapshot;
+    board_snapshot(board, &snapshot);
+    write_data(replay, REPLAY_MAGIC, 4);
+    write_data(replay, &version, sizeof(version));
+    write_data(replay, &rules_version, sizeof(rules_version));
+    write_data(replay, &board->seed, sizeof(board->seed));
+    write_data(replay, &snapshot, sizeof(snapshot));
+
+    board->replay = replay;
+    return replay;
+}
+
+
+/**
+ * Stop the recording, write the index of the keyframes and close the file of the replay.
+ *
+ * \param replay the replay concerned.
+*/
+void clean_replay(Replay** replay)
+{
+    Replay* _replay = (*replay);
+
+    write_record(_replay, REPLAY_END, NULL, 0);
+    write_index(_replay);
+    if (fclose(_replay->file) != 0 || _replay->write_error)
+        print_color("Error writing the replay file, it is incomplete", TXT_RED);
+    if (_replay->board->replay == _replay)
+        _replay->board->replay = NULL;
+
+    free(_replay->keyframes);
+    free(_replay);
+    *replay = NULL;
+}
+
+
+/**
+ * Record an input given to the board, INPUT_NONE changes nothing so it is not written.
+ *
+ * \param replay the replay concerned.
+ * \param input the input.
+*/
+void record_input(Replay* replay, BoardInput input)
+{
+    if (input == INPUT_NONE)
+        return;
+    const uint8_t data = input;
+    write_record(replay, REPLAY_INPUT, &data, sizeof(data));
+}
+
+
+/**
+ * Record an update of the board, only the changes of time are written.
+ * The keyframe asked since the last update is written before, when the board is between two updates.
+ *
+ * \param replay the replay concerned.
+ * \param delta_t the time of the update.
+*/
+void record_update(Replay* replay, double delta_t)
+{
+    if (replay->keyframe_needed)
+        write_keyframe(replay);
+    if (delta_t != replay->delta_t)
+    {
+        write_record(replay, REPLAY_DELTA, &delta_t, sizeof(delta_t));
+        replay->delta_t = delta_t;
+    }
+    replay->updates++;
+}
+
+
+/**
+ * Record garbage received by the board, the holes of its lines come from the random generator of the board.
+ *
+ * \param replay the replay concerned.
+ * \param number_of_lines the number of lines received.
+*/
+void record_lines(Replay* replay, uint8_t number_of_lines)
+{
+    write_record(replay, REPLAY_LINES, &number_of_lines, sizeof(number_of_lines));
+}
+
+
+/**
+ * Record a new tetromino of the board, a keyframe is asked every REPLAY_KEYFRAME_PIECES tetrominos.
+ *
+ * \param replay the replay concerned.
+*/
+void record_piece(Replay* replay)
+{
+    replay->pieces++;
+    if (replay->pieces >= REPLAY_KEYFRAME_PIECES)
+    {
+        replay->pieces = 0;
+        replay->keyframe_needed = true;
+    }
+}
+
+
+/**
+ * Map a replay file in memory to read it.
+ *
+ * \param path the path of the replay file.
+ * \return a new pointer of replay view, NULL if the file can't be read or was recorded with other rules.
+*/
+ReplayView* create_replay_view(const char* path)
+{
+    ReplayView* view = malloc(sizeof(ReplayView));
+    if (view == NULL)
+        return NULL;
+    if (!map_file(view, path))
+    {
+        print_color("Error opening the replay file", TXT_RED);
+        free(view);
+        return NULL;
+    }
+    if (!read_header(view))
+    {
+        unmap_file(view);
+        free(view);
+        return NULL;
+    }
+    read_index(view);
+    return view;
+}
+
+
+/**
+ * Unmap the file of a replay view.
+ *
+ * \param view the replay view concerned.
+*/
+void clean_replay_view(ReplayView** view)
+{
+    unmap_file(*view);
+    free(*view);
+    *view = NULL;
+}
+
+
+/**
+ * Read the record of a replay view at an offset.
+ *
+ * \param view the replay view concerned.
+ * \param offset the offset of the record, REPLAY_HEADER_SIZE for the first one, moved to the next record.
+ * \param entry the record read, its data points into the file.
+ * \return false if there is no complete record at the offset.
+*/
+bool next_replay_entry(const ReplayView* view, size_t* offset, ReplayEntry* entry)
+{
+    const size_t end = view->index != NULL ? (size_t) (view->index - view->data) : view->size;
+    if (*offset > end || end - *offset < REPLAY_RECORD_SIZE)
+        return false;
+
+    const uint8_t kind = view->data[*offset];
+    const size_t data_size = record_data_size(kind);
+    if (kind > REPLAY_KEYFRAME || end - *offset - REPLAY_RECORD_SIZE < data_size)
+        return false;
+
+    entry->kind = kind;
+    memcpy(&entry->updates, view->data + *offset + 1, sizeof(entry->updates));
+    entry->data = view->data + *offset + REPLAY_RECORD_SIZE;
+    *offset += REPLAY_RECORD_SIZE + data_size;
+    return true;
+}
+
+
+/**
+ * Put a board in the state of a replay after a number of updates, the callbacks of the board are called.
+ * The board starts from the last keyframe before the wanted update, then the records after it are simulated.
+ *
+ * \param view the replay view concerned.
+ * \param board the board concerned, it must not be recorded.
+ * \param updates the wanted number of updates, UINT32_MAX for the end of the replay.
+ * \return the number of updates of the board, lower than the wanted one if the replay ends before,
+ *         0 if the snapshot restored is not valid, the board is then unchanged.
+*/
+uint32_t seek_replay(const ReplayView* view, Board* board, uint32_t updates)
+{
+    size_t offset = REPLAY_HEADER_SIZE;
+    uint32_t board_updates = 0;
+    double delta_t = 0;
+    BoardSnapshot snapshot;
+    memcpy(&snapshot, view->data + REPLAY_SNAPSHOT_OFFSET, sizeof(snapshot));
+
+    // Binary search of the last keyframe before the wanted update
+    uint32_t low = 0;
+    uint32_t high = view->nb_keyframes;
+    while (low < high)
+    {
+        const uint32_t middle = low + (high - low) / 2;
+        uint32_t keyframe_updates;
+        memcpy(&keyframe_updates, view->index + middle * REPLAY_KEYFRAME_SIZE + sizeof(uint64_t), sizeof(keyframe_updates));
+        if (keyframe_updates <= updates)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low > 0)
+    {
+        uint64_t keyframe_offset;
+        memcpy(&keyframe_offset, view->index + (low - 1) * REPLAY_KEYFRAME_SIZE, sizeof(keyframe_offset));
+        size_t next_offset = keyframe_offset;
+        ReplayEntry keyframe;
+        if (next_replay_entry(view, &next_offset, &keyframe) && keyframe.kind == REPLAY_KEYFRAME)
+        {
+            memcpy(&delta_t, keyframe.data, sizeof(delta_t));
+            memcpy(&snapshot, keyframe.data + sizeof(delta_t), sizeof(snapshot));
+            board_updates = keyframe.updates;
+            offset = next_offset;
+        }
+    }
+
+    if (!board_restore(board, &snapshot))
+        return 0;
+    board->seed = view->seed;
+
+    ReplayEntry entry;
+    bool end = false;
+    bool after = false;
+    while (!end && !after && next_replay_entry(view, &offset, &entry))
+    {
+        after = entry.updates > updates;
+        if (after)
+            break;
+        for (; board_updates < entry.updates; board_updates++)
+            update_board(board, delta_t);
+
+        switch (entry.kind)
+        {
+            case REPLAY_INPUT:
+                board_input(board, entry.data[0]);
+                break;
+            case REPLAY_DELTA:
+                memcpy(&delta_t, entry.data, sizeof(delta_t));
+                break;
+            case REPLAY_LINES:
+                queue_garbage(board, entry.data[0]);
+                break;
+            case REPLAY_END:
+                end = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The records stop before the wanted update, the board is only updated
+    if (after)
+        for (; board_updates < updates; board_updates++)
+            update_board(board, delta_t);
+
+    return board_updates;
+}
+
+
+/* #################### PRIVATE #################### */
+
+/**
+ * Write data in the file of the replay.
+ * After a failed write nothing more is written, so the file ends like the replay of a crashed game.
+ *
+ * \param replay the replay concerned.
+ * \param data the data written.
+ * \param size the size of the data.
+*/
+void write_data(Replay* replay, const void* data, size_t size)
+{
+    if (replay->write_error)
+        return;
+    if (fwrite(data, size, 1, replay->file) != 1)
+    {
+        replay->write_error = true;
+        return;
+    }
+    replay->size += size;
+}
+
+
+/**
+ * Write a record in the file of the replay.
+ *
+ * \param replay the replay concerned.
+ * \param kind the kind of the record.
+ * \param data the data of the record.
+ * \param size the size of the data.
+*/
+void write_record(Replay* replay, ReplayRecord kind, const void* data, size_t size)
+{
+    const uint8_t _kind = kind;
+    write_data(replay, &_kind, sizeof(_kind));
+    write_data(replay, &replay->updates, sizeof(replay->updates));
+    if (size > 0)
+        write_data(replay, data, size);
+}
+
+
+/**
+ * Write a keyframe with the actual state of the board and keep its position for the index.
+ *
+ * \param replay the replay concerned.
+*/
+void write_keyframe(Replay* replay)
+{
+    replay->keyframe_needed = false;
+    if (replay->nb_keyframes == replay->size_keyframes)
+    {
+        const uint32_t size = replay->size_keyframes > 0 ? replay->size_keyframes * 2 : 64;
+        ReplayKeyframe* keyframes = realloc(replay->keyframes, size * sizeof(ReplayKeyframe));
+        if (keyframes == NULL)
+            return;
+        replay->keyframes = keyframes;
+        replay->size_keyframes = size;
+    }
+    replay->keyframes[replay->nb_keyframes].offset = replay->size;
+    replay->keyframes[replay->nb_keyframes].updates = replay->updates;
+    replay->nb_keyframes++;
+
+    uint8_t data[sizeof(double) + sizeof(BoardSnapshot)];
+    BoardSnapshot snapshot;
+    board_snapshot(replay->board, &snapshot);
+    memcpy(data, &replay->delta_t, sizeof(double));
+    memcpy(data + sizeof(double), &snapshot, sizeof(snapshot));
+    write_record(replay, REPLAY_KEYFRAME, data, sizeof(data));
+}
+
+
+/**
+ * Write the index of the keyframes at the end of the file of the replay.
+ *
+ * \param replay the replay concerned.
+*/
+void write_index(Replay* replay)
+{
+    for (uint32_t i = 0; i < replay->nb_keyframes; i++)
+    {
+        write_data(replay, &replay->keyframes[i].offset, sizeof(replay->keyframes[i].offset));
+        write_data(replay, &replay->keyframes[i].updates, sizeof(replay->keyframes[i].updates));
+    }
+    write_data(replay, &replay->nb_keyframes, sizeof(replay->nb_keyframes));
+    write_data(replay, &replay->updates, sizeof(replay->updates));
+    write_data(replay, REPLAY_INDEX_MAGIC, 4);
+}
+
+
+/**
+ * Check the header of a replay view and read its seed.
+ *
+ * \param view the replay view concerned.
+ * \return false if the file is not a replay of the actual rules.
+*/
+bool read_header(ReplayView* view)
+{
+    uint16_t version;
+    uint16_t rules_version;
+    if (view->size < REPLAY_HEADER_SIZE || memcmp(view->data, REPLAY_MAGIC, 4) != 0)
+    {
+        print_color("The file is not a replay", TXT_RED);
+        return false;
+    }
+    memcpy(&version, view->data + 4, sizeof(version));
+    memcpy(&rules_version, view->data + 6, sizeof(rules_version));
+    memcpy(&view->seed, view->data + 8, sizeof(view->seed));
+    if (version != REPLAY_VERSION)
+    {
+        print_color("The replay file was written by another version of the game", TXT_RED);
+        return false;
+    }
+    if (rules_version != RULES_VERSION)
+    {
+        print_color("The replay was recorded with other rules, it can't be played", TXT_RED);
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Find the index of the keyframes at the end of a replay view.
+ * Without index, or with a keyframe outside of the records, the replay can only be read from its start.
+ *
+ * \param view the replay view concerned.
+*/
+void read_index(ReplayView* view)
+{
+    view->index = NULL;
+    view->nb_keyframes = 0;
+    view->updates = 0;
+    if (view->size < REPLAY_HEADER_SIZE + REPLAY_INDEX_END_SIZE)
+        return;
+
+    const uint8_t* index_end = view->data + view->size - REPLAY_INDEX_END_SIZE;
+    uint32_t nb_keyframes;
+    memcpy(&nb_keyframes, index_end, sizeof(nb_keyframes));
+    if (memcmp(index_end + 8, REPLAY_INDEX_MAGIC, 4) != 0
+        || nb_keyframes > (view->size - REPLAY_HEADER_SIZE - REPLAY_INDEX_END_SIZE) / REPLAY_KEYFRAME_SIZE)
+        return;
+
+    // Every keyframe must be a record between the header and the index
+    const uint8_t* index = index_end - (size_t) nb_keyframes * REPLAY_KEYFRAME_SIZE;
+    for (uint32_t i = 0; i < nb_keyframes; i++)
+    {
+        uint64_t keyframe_offset;
+        memcpy(&keyframe_offset, index + i * REPLAY_KEYFRAME_SIZE, sizeof(keyframe_offset));
+        if (keyframe_offset < REPLAY_HEADER_SIZE || keyframe_offset >= (uint64_t) (index - view->data))
+            return;
+    }
+
+    view->index = index;
+    view->nb_keyframes = nb_keyframes;
+    memcpy(&view->updates, index_end + 4, sizeof(view->updates));
+}
+
+
+/**
+ * Give the size of the data of a record.
+ *
+ * \param kind the kind of the record.
+ * \return the size of its data in bytes.
+*/
+size_t record_data_size(uint8_t kind)
+{
+    switch (kind)
+    {
+        case REPLAY_INPUT:
+        case REPLAY_LINES:
+            return 1;
+        case REPLAY_DELTA:
+            return sizeof(double);
+        case REPLAY_KEYFRAME:
+            return sizeof(double) + sizeof(BoardSnapshot);
+        default:
+            return 0;
+    }
+}
+
+
+#ifdef _WIN32
+
+/**
+ * Map a file in memory, read only.
+ *
+ * \param view the replay view getting the mapping.
+ * \param path the path of the file.
+ * \return false if the file can't be mapped.
+*/
+bool map_file(ReplayView* view, const char* path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    const uint8_t* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    view->data = data;
+    view->size = (size_t) size.QuadPart;
+    view->file_handle = file;
+    view->mapping_handle = mapping;
+    return true;
+}
+
+
+/**
+ * Unmap the file of a replay view.
+ *
+ * \param view the replay view concerned.
+*/
+void unmap_file(ReplayView* view)
+{
+    UnmapViewOfFile(view->data);
+    CloseHandle(view->mapping_handle);
+    CloseHandle(view->file_handle);
+}
+
+#else
+
+/**
+ * Map a file in memory, read only.
+ *
+ * \param view the replay view getting the mapping.
+ * \param path the path of the file.
+ * \return false if the file can't be mapped.
+*/
+bool map_file(ReplayView* view, const char* path)
+{
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+    view->data = data;
+    view->size = (size_t) status.st_size;
+    view->file_handle = NULL;
+    view->mapping_handle = NULL;
+    return true;
+}
+
+
+/**
+ * Unmap the file of a replay view.
+ *
+ * \param view the replay view concerned.
+*/
+void unmap_file(ReplayView* view)
+{
+    munmap((void*) view->data, view->size);
+}
+
+#endif
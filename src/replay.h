@@ -0,0 +1,84 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#define REPLAY_MAGIC "TRPL"
+#define REPLAY_INDEX_MAGIC "TIDX"
+#define REPLAY_VERSION 2          // Changes when the layout of the replay files changes
+#define REPLAY_KEYFRAME_PIECES 50 // The number of tetrominos between two keyframes
+#define REPLAY_SNAPSHOT_OFFSET 16 // The magic, the versions and the seed are before the snapshot of the header
+#define REPLAY_HEADER_SIZE (REPLAY_SNAPSHOT_OFFSET + sizeof(BoardSnapshot)) // The offset of the first record
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "board.h"
+
+/* A replay file (native byte order, no alignment) :
+   - the header : REPLAY_MAGIC, REPLAY_VERSION (uint16), RULES_VERSION (uint16), the seed (uint64)
+     and the snapshot of the board when the recording started (BoardSnapshot),
+   - the records : a kind (uint8), the number of updates of the board before it (uint32) and its data,
+   - a REPLAY_END record,
+   - the index of the keyframes : for each keyframe its offset in the file (uint64) and its number of updates (uint32),
+     then the number of keyframes (uint32), the number of updates of the replay (uint32) and REPLAY_INDEX_MAGIC.
+   The end record and the index are missing if the game crashed during the recording. */
+typedef enum ReplayRecord {
+    REPLAY_END,     // No data, the number of updates is the total
+    REPLAY_INPUT,   // The input given to the board (uint8)
+    REPLAY_DELTA,   // The time of the next updates (double), only written when it changes
+    REPLAY_LINES,   // The number of lines of garbage received by the board (uint8)
+    REPLAY_KEYFRAME // The time of the next updates (double) and the snapshot of the board (BoardSnapshot)
+} ReplayRecord;
+
+typedef struct ReplayKeyframe {
+    uint64_t offset;  // The offset of the keyframe record in the file
+    uint32_t updates; // The number of updates of the board before the keyframe
+} ReplayKeyframe;
+
+typedef struct Replay {
+    FILE* file;                // The file written
+    Board* board;              // The board recorded
+    uint64_t size;             // The number of bytes written in the file
+    uint32_t updates;          // The number of updates of the board since the start of the recording
+    double delta_t;            // The time of the last update written, negative before the first one
+    uint16_t pieces;           // The number of tetrominos since the last keyframe
+    bool keyframe_needed;      // If a keyframe is written before the next update
+    ReplayKeyframe* keyframes; // The keyframes written, for the index
+    uint32_t nb_keyframes;     // The number of keyframes written
+    uint32_t size_keyframes;   // The size of the keyframes array
+    bool write_error;          // If a write failed, nothing is written after it
+} Replay;
+
+/* A replay file mapped in memory, it is read without copy. */
+typedef struct ReplayView {
+    const uint8_t* data;     // The content of the file
+    size_t size;             // The size of the file
+    uint64_t seed;           // The seed of the recorded board
+    const uint8_t* index;    // The index of the keyframes, NULL if the replay is incomplete
+    uint32_t nb_keyframes;   // The number of keyframes in the index
+    uint32_t updates;        // The number of updates of the replay, 0 if the replay is incomplete
+    void* file_handle;       // The handles of the mapping on Windows
+    void* mapping_handle;
+} ReplayView;
+
+/* A record read from a replay view, its data points into the file. */
+typedef struct ReplayEntry {
+    ReplayRecord kind;
+    uint32_t updates;        // The number of updates of the board before the record
+    const uint8_t* data;     // The data of the record
+} ReplayEntry;
+
+Replay* create_replay(Board* board, const char* path);
+void clean_replay(Replay** replay);
+void record_input(Replay* replay, BoardInput input);
+void record_update(Replay* replay, double delta_t);
+void record_lines(Replay* replay, uint8_t number_of_lines);
+void record_piece(Replay* replay);
+
+ReplayView* create_replay_view(const char* path);
+void clean_replay_view(ReplayView** view);
+bool next_replay_entry(const ReplayView* view, size_t* offset, ReplayEntry* entry);
+uint32_t seek_replay(const ReplayView* view, Board* board, uint32_t updates);
+
+#endif // REPLAY_H
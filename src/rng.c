@@ -0,0 +1,49 @@
+#include "rng.h"
+
+#define RNG_MULTIPLIER 6364136223846793005ULL
+#define RNG_INCREMENT 1442695040888963407ULL
+
+
+/**
+ * Seed a random generator, the same seed always gives the same numbers.
+ *
+ * \param rng the generator to seed.
+ * \param seed the seed.
+*/
+void seed_rng(Rng* rng, uint64_t seed)
+{
+    rng->state = 0;
+    next_random(rng);
+    rng->state += seed;
+    next_random(rng);
+}
+
+
+/**
+ * Get the next random number of a generator (PCG32 XSH RR).
+ *
+ * \param rng the generator concerned.
+ * \return a random number on 32 bits.
+*/
+uint32_t next_random(Rng* rng)
+{
+    uint64_t old_state = rng->state;
+    rng->state = old_state * RNG_MULTIPLIER + RNG_INCREMENT;
+
+    uint32_t xorshifted = (uint32_t) (((old_state >> 18) ^ old_state) >> 27);
+    uint32_t rotation = (uint32_t) (old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+
+/**
+ * Get a random number between 0 (included) and bound (excluded).
+ *
+ * \param rng the generator concerned.
+ * \param bound the upper bound, must not be 0.
+ * \return a random number lower than bound.
+*/
+uint32_t random_below(Rng* rng, uint32_t bound)
+{
+    return (uint32_t) (((uint64_t) next_random(rng) * bound) >> 32);
+}
@@ -0,0 +1,14 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+typedef struct Rng {
+    uint64_t state; // The state of the generator (PCG32 with a fixed increment)
+} Rng;
+
+void seed_rng(Rng* rng, uint64_t seed);
+uint32_t next_random(Rng* rng);
+uint32_t random_below(Rng* rng, uint32_t bound);
+
+#endif // RNG_H
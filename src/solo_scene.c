@@ -1,10 +1,12 @@
 #include "solo_scene.h"
 
 #include <stdio.h>
+#include <time.h>
 
 #include "print_color.h"
 #include "utils.h"
 #include "board.h"
+#include "board_view.h"
 #include "global.h"
 #include "tetromino.h"
 #include "tetris.h"
@@ -15,8 +17,8 @@ SoloScene* solo_scene = NULL;
 
 /* SoloScene variables */
 double ss_delta_t;
-uint64_t ss_start, ss_end;
 bool ss_started = false;
+bool ss_redraw = true;
 const SDL_Rect board_pos = {100, 4, 388, 708};
 
 /* Buttons */
@@ -47,6 +49,9 @@ void ss_resume_callback();
 void ss_full_callback();
 void ss_back_callback();
 
+void ss_start_recording();
+void ss_stop_recording();
+
 
 /* #################### PUBLIC #################### */
 
@@ -54,9 +59,10 @@ void ss_back_callback();
  * Create the solo scene.
  * 
  * \param window the main window.
- * \param board_sprite the image with all textures.
+ * \param scheduler the scheduler of the frames of the game.
+ * \param replay_path the file where the games are recorded, NULL to not record them.
 */
-SoloScene* create_solo_scene(SDL_Window* window) 
+SoloScene* create_solo_scene(SDL_Window* window, FrameScheduler* scheduler, const char* replay_path)
 {
     SoloScene* _solo_scene = malloc(sizeof(SoloScene));
     if (_solo_scene == NULL)
@@ -76,10 +82,14 @@ SoloScene* create_solo_scene(SDL_Window* window)
     }
     _solo_scene->window = window;
     _solo_scene->renderer = SDL_GetRenderer(window);
+    _solo_scene->scheduler = scheduler;
     _solo_scene->ss_init = &ss_init;
     _solo_scene->ss_loop = &ss_loop;
     _solo_scene->ss_clean = &ss_clean;
     _solo_scene->board = NULL;
+    _solo_scene->replay_path = replay_path;
+    _solo_scene->replay = NULL;
+    _solo_scene->board_view = NULL;
     _solo_scene->nb_buttons = 0;
     _solo_scene->nb_keys = 0;
     _solo_scene->return_code = 0;
@@ -101,12 +111,18 @@ bool ss_init()
     print_color("   Solo Scene init", TXT_GREEN);
 
     print_color("   Creating board for solo scene", TXT_GREEN);
-    solo_scene->board = create_board(board_pos, true, &ss_full_callback);
+    solo_scene->board = create_board(&ss_full_callback, (uint64_t) time(NULL));
     if(solo_scene->board == NULL) 
     {
         print_color("   Error Creating board for solo scene", TXT_RED);
         return false;
     }
+    solo_scene->board_view = create_board_view(solo_scene->board, solo_scene->renderer, board_pos, true);
+    if(solo_scene->board_view == NULL) 
+    {
+        print_color("   Error Creating board view for solo scene", TXT_RED);
+        return false;
+    }
     
     print_color("   Creating buttons for solo scene", TXT_GREEN);
     if(!ss_create_buttons()) 
@@ -252,17 +268,17 @@ bool ss_create_texts()
 uint8_t ss_loop()
 {
     print_color("Solo Scene loop", TXT_BLUE);
+    ss_redraw = true;
     while(!solo_scene->return_code) 
     {
-        ss_start = SDL_GetPerformanceCounter();
+        ss_delta_t = begin_frame(solo_scene->scheduler);
 
         ss_event();
         ss_update();
         ss_draw();
 
-        ss_end = SDL_GetPerformanceCounter();
-		
-	    ss_delta_t = (double)((ss_end - ss_start) * 1000 / (double)SDL_GetPerformanceFrequency());
+        // Nothing moves when the game is not started, wait for an event
+        end_frame(solo_scene->scheduler, !ss_started);
     }
     print_color("End Solo Scene loop", TXT_BLUE);
     return solo_scene->return_code;
@@ -277,6 +293,8 @@ void ss_clean()
     print_color("  Solo Scene clean", TXT_GREEN);
 
     print_color("    Cleaning board", TXT_GREEN);
+    ss_stop_recording();
+    if (solo_scene->board_view != NULL) clean_board_view(&solo_scene->board_view);
     if (solo_scene->board != NULL) clean_board(&solo_scene->board);
 
     print_color("    Cleaning buttons", TXT_GREEN);
@@ -313,9 +331,18 @@ void ss_event()
                 break;
             case SDL_MOUSEBUTTONDOWN:
                 check_buttons_click(solo_scene->buttons, solo_scene->nb_buttons, event.button);
+                ss_redraw = true;
                 break;
             case SDL_MOUSEMOTION:
-                check_buttons_hover(solo_scene->buttons, solo_scene->nb_buttons, event.motion);
+                ss_redraw |= check_buttons_hover(solo_scene->buttons, solo_scene->nb_buttons, event.motion);
+                break;
+            case SDL_WINDOWEVENT:
+                ss_redraw = true;
+                break;
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                invalidate_board_view(solo_scene->board_view);
+                ss_redraw = true;
                 break;
             case SDL_KEYDOWN:
                 ss_keyboard_event(event.key);
@@ -355,11 +382,16 @@ void ss_update()
 */
 void ss_draw() 
 {
+    // Nothing changed, the window keeps the last frame
+    if (!ss_redraw && !board_view_changed(solo_scene->board_view))
+        return;
+    ss_redraw = false;
+
     SDL_UpdateWindowSurface(solo_scene->window);
     SDL_RenderClear(solo_scene->renderer);
 
     // Draw the board
-    draw_board(solo_scene->board, solo_scene->renderer);
+    draw_board_view(solo_scene->board_view, solo_scene->renderer);
 
     // Draw all the buttons
     for(uint8_t i = 0; i < solo_scene->nb_buttons; i++)
@@ -380,9 +412,11 @@ void ss_draw()
 */
 void ss_full_callback() 
 {
+    ss_redraw = true;
     ss_btn_restart->visible = true;
     ss_btn_pause->visible = false;
     ss_started = false;
+    ss_stop_recording();
 }
 
 
@@ -394,6 +428,7 @@ void ss_start_callback()
     ss_started = true;
     ss_btn_start->visible = false;
     ss_btn_pause->visible = true;
+    ss_start_recording();
 }
 
 
@@ -406,6 +441,7 @@ void ss_restart_callback()
     reset_board(solo_scene->board);
     ss_btn_pause->visible = true;
     ss_started = true;
+    ss_start_recording();
 }
 
 
@@ -437,6 +473,7 @@ void ss_resume_callback()
 void ss_back_callback() 
 {
     ss_started = false;
+    ss_stop_recording();
     reset_board(solo_scene->board);
     ss_btn_start->visible = true;
     ss_btn_pause->visible = false;
@@ -444,3 +481,29 @@ void ss_back_callback()
     ss_btn_restart->visible = false;
     solo_scene->return_code = T_MENU;
 }
+
+
+/* #################### REPLAY METHODS #################### */
+
+/**
+ * Start recording the game of the solo scene if there is a replay file, the previous game is replaced.
+*/
+void ss_start_recording()
+{
+    if (solo_scene->replay_path == NULL)
+        return;
+    ss_stop_recording();
+    solo_scene->replay = create_replay(solo_scene->board, solo_scene->replay_path);
+    if (solo_scene->replay == NULL)
+        print_color("Error creating the replay of the solo game", TXT_RED);
+}
+
+
+/**
+ * Stop recording the game of the solo scene and close the replay file.
+*/
+void ss_stop_recording()
+{
+    if (solo_scene->replay != NULL)
+        clean_replay(&solo_scene->replay);
+}
@@ -12,12 +12,19 @@
 
 #include "button.h"
 #include "board.h"
+#include "board_view.h"
 #include "text.h"
+#include "frame_scheduler.h"
+#include "replay.h"
 
 typedef struct SoloScene {
     SDL_Window* window;
     SDL_Renderer* renderer;
+    FrameScheduler* scheduler;
     Board* board;
+    const char* replay_path; // The file where the games are recorded, NULL to not record them
+    Replay* replay;          // The recording of the actual game, NULL if there is none
+    BoardView* board_view;
     Button** buttons;
     uint8_t nb_buttons;
     bool (*ss_init)();
@@ -28,6 +35,6 @@ typedef struct SoloScene {
     uint8_t nb_keys;
 } SoloScene;
 
-SoloScene* create_solo_scene(SDL_Window* window);
+SoloScene* create_solo_scene(SDL_Window* window, FrameScheduler* scheduler, const char* replay_path);
 
 #endif //SOLO_SCENE_H
@@ -1,11 +1,13 @@
 #include "test.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "tetromino.h"
 #include "print_color.h"
 
-void place_tetromino(Tetromino* tetromino, uint8_t x, uint8_t y, uint8_t rotation);
+bool place_tetromino(Square* squares, BlockType block_type, uint8_t x, uint8_t y, uint8_t rotation);
+void lock_test_tetromino(Board* board, BlockType block_type, uint8_t x, uint8_t y, uint8_t rotation);
 
 /**
  * Fill the board for a test.
@@ -14,132 +16,36 @@ void place_tetromino(Tetromino* tetromino, uint8_t x, uint8_t y, uint8_t rotatio
 */
 void test_map1(Board* board) 
 {
-	uint8_t i = 0;
-
 	// Right
-	Tetromino* tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 19, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 18, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 17, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 16, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 15, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 14, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 13, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 12, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 11, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 10, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 6, 19, 0);
+	lock_test_tetromino(board, I, 6, 18, 0);
+	lock_test_tetromino(board, I, 6, 17, 0);
+	lock_test_tetromino(board, I, 6, 16, 0);
+	lock_test_tetromino(board, I, 6, 15, 0);
+	lock_test_tetromino(board, I, 6, 14, 0);
+	lock_test_tetromino(board, I, 6, 13, 0);
+	lock_test_tetromino(board, I, 6, 12, 0);
+	lock_test_tetromino(board, I, 6, 11, 0);
+	lock_test_tetromino(board, I, 6, 10, 0);
 
 	// Left
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 19, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 18, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 17, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 16, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 15, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 14, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 13, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 12, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 11, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 10, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 4, 16, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 4, 12, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 4, 8, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	/*tetromino = create_tetromino(T);
-	place_tetromino(tetromino, 1, 14, 0);
-	board->tetrominos[i] = tetromino;
-	i++;*/
-
-	board->nb_tetrominos = i;
-	board->next_tetromino = create_tetromino(I);
+	lock_test_tetromino(board, I, 0, 19, 0);
+	lock_test_tetromino(board, I, 0, 18, 0);
+	lock_test_tetromino(board, I, 0, 17, 0);
+	lock_test_tetromino(board, I, 0, 16, 0);
+	lock_test_tetromino(board, I, 0, 15, 0);
+	lock_test_tetromino(board, I, 0, 14, 0);
+	lock_test_tetromino(board, I, 0, 13, 0);
+	lock_test_tetromino(board, I, 0, 12, 0);
+	lock_test_tetromino(board, I, 0, 11, 0);
+	lock_test_tetromino(board, I, 0, 10, 0);
+	lock_test_tetromino(board, I, 4, 16, 1);
+	lock_test_tetromino(board, I, 4, 12, 1);
+	lock_test_tetromino(board, I, 4, 8, 1);
+
+	/*lock_test_tetromino(board, T, 1, 14, 0);*/
+
+	board->queue[board->queue_head] = I;
 }
 
 
@@ -150,39 +56,17 @@ void test_map1(Board* board)
 */
 void test_map2(Board* board) 
 {
-	uint8_t i = 0;
-
 	// Left
-	Tetromino* tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 3, 16, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(J);
-	place_tetromino(tetromino, 2, 19, 2);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(O);
-	place_tetromino(tetromino, 1, 17, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 3, 16, 1);
+	lock_test_tetromino(board, J, 2, 19, 2);
+	lock_test_tetromino(board, O, 1, 17, 0);
 
 	// Right
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 9, 16, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 9, 16, 1);
+	lock_test_tetromino(board, O, 7, 18, 0);
 
-	tetromino = create_tetromino(O);
-	place_tetromino(tetromino, 7, 18, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
 
-	board->nb_tetrominos = i;
-
-	clean_tetromino(&board->next_tetromino);
-	board->next_tetromino = create_tetromino(J);
+	board->queue[board->queue_head] = J;
 	update_board(board, 500);
 }
 
@@ -192,168 +76,150 @@ void test_map2(Board* board)
 */
 void test_map3(Board* board) 
 {
-	uint8_t i = 0;
-
 	// Left
-	Tetromino* tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 19, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 4, 16, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(Z);
-	place_tetromino(tetromino, 1, 17, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(J);
-	place_tetromino(tetromino, 0, 18, 3);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 3, 14, 1);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 0, 19, 0);
+	lock_test_tetromino(board, I, 4, 16, 1);
+	lock_test_tetromino(board, Z, 1, 17, 1);
+	lock_test_tetromino(board, J, 0, 18, 3);
+	lock_test_tetromino(board, I, 3, 14, 1);
 
 	// Right
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 19, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 18, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 17, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
-
-	tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 6, 16, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 6, 19, 0);
+	lock_test_tetromino(board, I, 6, 18, 0);
+	lock_test_tetromino(board, I, 6, 17, 0);
+	lock_test_tetromino(board, I, 6, 16, 0);
 
-	board->nb_tetrominos = i;
 
-	clean_tetromino(&board->next_tetromino);
-	board->next_tetromino = create_tetromino(I);
+	board->queue[board->queue_head] = I;
 }
 
 
 void test_map4(Board* board) 
 {
-	uint8_t i = 0;
-
 	// Left
-	Tetromino* tetromino = create_tetromino(I);
-	place_tetromino(tetromino, 0, 19, 0);
-	board->tetrominos[i] = tetromino;
-	i++;
+	lock_test_tetromino(board, I, 0, 19, 0);
 
-	board->nb_tetrominos = i;
 
-	clean_tetromino(&board->next_tetromino);
-	board->next_tetromino = create_tetromino(S);
+	board->queue[board->queue_head] = S;
 }
 
 /**
- * Place a tetromino at certain coordinates
+ * Place the squares of a tetromino at certain coordinates
+ * 
+ * \return false if the block type is not supported.
 */
-void place_tetromino(Tetromino* tetromino, uint8_t x, uint8_t y, uint8_t rotation) 
+bool place_tetromino(Square* squares, BlockType block_type, uint8_t x, uint8_t y, uint8_t rotation) 
 {
-	switch(tetromino->block_type) 
+	switch(block_type) 
 	{
 		case I:
 			if(rotation == 0)
 			{
-				tetromino->squares[0]->x = x;
-				tetromino->squares[0]->y = y;
-				tetromino->squares[1]->x = x + 1;
-				tetromino->squares[1]->y = y;
-				tetromino->squares[2]->x = x + 2;
-				tetromino->squares[2]->y = y;
-				tetromino->squares[3]->x = x + 3;
-				tetromino->squares[3]->y = y;
+				squares[0].x = x;
+				squares[0].y = y;
+				squares[1].x = x + 1;
+				squares[1].y = y;
+				squares[2].x = x + 2;
+				squares[2].y = y;
+				squares[3].x = x + 3;
+				squares[3].y = y;
 			}
 			else 
 			{
-				tetromino->squares[0]->x = x;
-				tetromino->squares[0]->y = y;
-				tetromino->squares[1]->x = x;
-				tetromino->squares[1]->y = y + 1;
-				tetromino->squares[2]->x = x;
-				tetromino->squares[2]->y = y + 2;
-				tetromino->squares[3]->x = x;
-				tetromino->squares[3]->y = y + 3;
+				squares[0].x = x;
+				squares[0].y = y;
+				squares[1].x = x;
+				squares[1].y = y + 1;
+				squares[2].x = x;
+				squares[2].y = y + 2;
+				squares[3].x = x;
+				squares[3].y = y + 3;
 			}
 			break;
 		case T:
-			tetromino->squares[0]->x = x;
-			tetromino->squares[0]->y = y;
-			tetromino->squares[1]->x = x + 1;
-			tetromino->squares[1]->y = y;
-			tetromino->squares[2]->x = x + 2;
-			tetromino->squares[2]->y = y;
-			tetromino->squares[3]->x = x + 1;
-			tetromino->squares[3]->y = y + 1;
+			squares[0].x = x;
+			squares[0].y = y;
+			squares[1].x = x + 1;
+			squares[1].y = y;
+			squares[2].x = x + 2;
+			squares[2].y = y;
+			squares[3].x = x + 1;
+			squares[3].y = y + 1;
 			break;
 		case J:
 			if (rotation == 2) 
 			{
-				tetromino->squares[0]->x = x;
-				tetromino->squares[0]->y = y;
-				tetromino->squares[1]->x = x - 1;
-				tetromino->squares[1]->y = y;
-				tetromino->squares[2]->x = x - 2;
-				tetromino->squares[2]->y = y;
-				tetromino->squares[3]->x = x - 2;
-				tetromino->squares[3]->y = y - 1;
+				squares[0].x = x;
+				squares[0].y = y;
+				squares[1].x = x - 1;
+				squares[1].y = y;
+				squares[2].x = x - 2;
+				squares[2].y = y;
+				squares[3].x = x - 2;
+				squares[3].y = y - 1;
 			}
 			else if (rotation == 3) 
 			{
-				tetromino->squares[0]->x = x;
-				tetromino->squares[0]->y = y;
-				tetromino->squares[1]->x = x;
-				tetromino->squares[1]->y = y - 1;
-				tetromino->squares[2]->x = x;
-				tetromino->squares[2]->y = y - 2;
-				tetromino->squares[3]->x = x + 1;
-				tetromino->squares[3]->y = y - 2;
+				squares[0].x = x;
+				squares[0].y = y;
+				squares[1].x = x;
+				squares[1].y = y - 1;
+				squares[2].x = x;
+				squares[2].y = y - 2;
+				squares[3].x = x + 1;
+				squares[3].y = y - 2;
 			}
 			break;
 		case O:
-			tetromino->squares[0]->x = x;
-			tetromino->squares[0]->y = y;
-			tetromino->squares[1]->x = x + 1;
-			tetromino->squares[1]->y = y;
-			tetromino->squares[2]->x = x;
-			tetromino->squares[2]->y = y + 1;
-			tetromino->squares[3]->x = x + 1;
-			tetromino->squares[3]->y = y + 1;
+			squares[0].x = x;
+			squares[0].y = y;
+			squares[1].x = x + 1;
+			squares[1].y = y;
+			squares[2].x = x;
+			squares[2].y = y + 1;
+			squares[3].x = x + 1;
+			squares[3].y = y + 1;
 			break;
 		case Z:
-			tetromino->squares[0]->x = x;
-			tetromino->squares[0]->y = y;
-			tetromino->squares[1]->x = x + 1;
-			tetromino->squares[1]->y = y;
-			tetromino->squares[2]->x = x + 1;
-			tetromino->squares[2]->y = y + 1;
-			tetromino->squares[3]->x = x + 2;
-			tetromino->squares[3]->y = y + 1;
+			squares[0].x = x;
+			squares[0].y = y;
+			squares[1].x = x + 1;
+			squares[1].y = y;
+			squares[2].x = x + 1;
+			squares[2].y = y + 1;
+			squares[3].x = x + 2;
+			squares[3].y = y + 1;
 			break;
 		case S:
 		case B_NONE:
 		case B_MAX:
 		default:
 			print_color("[Test](place_tetromino) block type not supported", TXT_RED);
-			break;
+			return false;
+	}
+	return true;
+}
+
+
+/**
+ * Lock the squares of a tetromino in the map of the board.
+ *
+ * \param board the board concerned.
+ * \param block_type the block type of the tetromino.
+ * \param x the x of the first square.
+ * \param y the y of the first square.
+ * \param rotation the rotation of the tetromino.
+*/
+void lock_test_tetromino(Board* board, BlockType block_type, uint8_t x, uint8_t y, uint8_t rotation)
+{
+	Square squares[NB_SQUARES];
+	if (!place_tetromino(squares, block_type, x, y, rotation))
+		return;
+
+	for (uint8_t i = 0; i < NB_SQUARES; i++)
+	{
+		board->map.rows[squares[i].y] |= 1 << squares[i].x;
+		board->map.colors[squares[i].y][squares[i].x] = get_color_for_block_type(block_type);
 	}
+	update_heights(board);
 }
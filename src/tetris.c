@@ -3,7 +3,6 @@
 #include "print_color.h"
 #include "global.h"
 
-#include <time.h> 
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -33,9 +32,11 @@ bool init_icon();
  * Create the tetris game. 
  * Initialize all the variables in the struct.
  * 
+ * \param frame_rate the target number of frames per second.
+ * \param replay_path the file where the solo games are recorded, NULL to not record them.
  * \return a new pointer of the game.
 */
-Tetris* create_game() 
+Tetris* create_game(uint16_t frame_rate, const char* replay_path)
 {
     Tetris* _tetris = malloc(sizeof(Tetris));
     if (_tetris == NULL)
@@ -47,6 +48,9 @@ Tetris* create_game()
     _tetris->height = HEIGHT;
     _tetris->window = NULL;
     _tetris->renderer = NULL;
+    _tetris->frame_scheduler = NULL;
+    _tetris->frame_rate = frame_rate;
+    _tetris->replay_path = replay_path;
     _tetris->run = &run;
     _tetris->menu_scene = NULL;
     _tetris->solo_scene = NULL;
@@ -105,11 +109,16 @@ bool init()
 {
     print_color("Init", TXT_BLUE);
 
-    srand(time(NULL));
-    //srand(3);
-
     if (!init_ui())
         return false;
+
+    print_color(" Creating the frame scheduler", TXT_BLUE);
+    tetris->frame_scheduler = create_frame_scheduler(tetris->frame_rate);
+    if (tetris->frame_scheduler == NULL)
+    {
+        print_color(" Error creating the frame scheduler", TXT_RED);
+        return false;
+    }
     
     if (!init_sprites())
         return false;
@@ -137,6 +146,7 @@ void clean()
     if(tetris->solo_scene != NULL) tetris->solo_scene->ss_clean();
     if(tetris->menu_scene != NULL) tetris->menu_scene->ms_clean();
     free_textures();
+    clean_frame_scheduler(&tetris->frame_scheduler);
     if(tetris->renderer != NULL) SDL_DestroyRenderer(tetris->renderer);
     if(tetris->window != NULL) SDL_DestroyWindow(tetris->window);
     SDL_Quit();
@@ -331,7 +341,7 @@ bool init_scenes()
 bool init_menu_scene() 
 {
     print_color("  Creating menu scene", TXT_GREEN);
-    tetris->menu_scene = create_menu_scene(tetris->window);
+    tetris->menu_scene = create_menu_scene(tetris->window, tetris->frame_scheduler);
     if (tetris->menu_scene == NULL)
     {
         print_color("  Error creating menu scene", TXT_RED);
@@ -358,7 +368,7 @@ bool init_menu_scene()
 bool init_solo_scene() 
 {
     print_color("  Creating solo scene", TXT_GREEN);
-    tetris->solo_scene = create_solo_scene(tetris->window);
+    tetris->solo_scene = create_solo_scene(tetris->window, tetris->frame_scheduler, tetris->replay_path);
     if (tetris->solo_scene == NULL)
     {
         print_color("  Error creating solo scene", TXT_RED);
@@ -385,7 +395,7 @@ bool init_solo_scene()
 bool init_ai_scene() 
 {
     print_color("  Creating ai scene", TXT_GREEN);
-    tetris->ai_scene = create_ai_scene(tetris->window);
+    tetris->ai_scene = create_ai_scene(tetris->window, tetris->frame_scheduler);
     if (tetris->ai_scene == NULL)
     {
         print_color("  Error creating ai scene", TXT_RED);
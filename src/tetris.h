@@ -10,6 +10,7 @@
 #include "menu_scene.h"
 #include "solo_scene.h"
 #include "ai_scene.h"
+#include "frame_scheduler.h"
 
 #define T_EXIT 255   // Exit the game
 #define T_SP 1       // Go to singleplayer
@@ -26,12 +27,15 @@ typedef struct Tetris {
     uint16_t height;
     SDL_Window* window;
     SDL_Renderer* renderer;
+    FrameScheduler* frame_scheduler;
+    uint16_t frame_rate;
+    const char* replay_path; // The file where the solo games are recorded, NULL to not record them
     MenuScene* menu_scene;
     SoloScene* solo_scene;
     AIScene* ai_scene;
     void (*run)();
 } Tetris;
 
-Tetris* create_game();
+Tetris* create_game(uint16_t frame_rate, const char* replay_path);
 
 #endif // TETRIS_H
@@ -1,70 +1,193 @@
 #include "tetromino.h"
 
-#include "global.h"
-#include "utils.h"
 #include "print_color.h"
 
 
-/* Local functions declaration */
-Square** create_squares(BlockType block_type);
-Square* create_square(int8_t x, int8_t y);
-
-void fill_moves_for_I(uint8_t rotation, int8_t** moves);
-void fill_moves_for_J(uint8_t rotation, int8_t** moves);
-void fill_moves_for_L(uint8_t rotation, int8_t** moves);
-//void fill_moves_for_O(uint8_t rotation, int8_t** moves);
-void fill_moves_for_S(uint8_t rotation, int8_t** moves);
-void fill_moves_for_T(uint8_t rotation, int8_t** moves);
-void fill_moves_for_Z(uint8_t rotation, int8_t** moves);
+/* The cells of each block type for each rotation state of the Super Rotation System,
+   relative to the origin of the tetromino. The states are the clockwise rotations
+   of the spawn state inside a 3x3 box (a 4x4 box for I), the O never rotates. */
+static const Square cells[B_MAX][NB_ROTATIONS][NB_SQUARES] = {
+    [I] = {
+        { {0, 1}, {1, 1}, {2, 1}, {3, 1} },    // [0][1][2][3]
+        { {2, 0}, {2, 1}, {2, 2}, {2, 3} },
+        { {3, 2}, {2, 2}, {1, 2}, {0, 2} },
+        { {1, 3}, {1, 2}, {1, 1}, {1, 0} },
+    },
+    [J] = {
+        { {0, 0}, {0, 1}, {1, 1}, {2, 1} },    // [0]
+        { {2, 0}, {1, 0}, {1, 1}, {1, 2} },    // [1][2][3]
+        { {2, 2}, {2, 1}, {1, 1}, {0, 1} },
+        { {0, 2}, {1, 2}, {1, 1}, {1, 0} },
+    },
+    [L] = {
+        { {2, 0}, {0, 1}, {1, 1}, {2, 1} },    //       [0]
+        { {2, 2}, {1, 0}, {1, 1}, {1, 2} },    // [1][2][3]
+        { {0, 2}, {2, 1}, {1, 1}, {0, 1} },
+        { {0, 0}, {1, 2}, {1, 1}, {1, 0} },
+    },
+    [O] = {
+        { {1, 0}, {2, 0}, {1, 1}, {2, 1} },    // [0][1]
+        { {1, 0}, {2, 0}, {1, 1}, {2, 1} },    // [2][3]
+        { {1, 0}, {2, 0}, {1, 1}, {2, 1} },
+        { {1, 0}, {2, 0}, {1, 1}, {2, 1} },
+    },
+    [S] = {
+        { {1, 0}, {2, 0}, {0, 1}, {1, 1} },    //    [0][1]
+        { {2, 1}, {2, 2}, {1, 0}, {1, 1} },    // [2][3]
+        { {1, 2}, {0, 2}, {2, 1}, {1, 1} },
+        { {0, 1}, {0, 0}, {1, 2}, {1, 1} },
+    },
+    [T] = {
+        { {1, 0}, {0, 1}, {1, 1}, {2, 1} },    //    [0]
+        { {2, 1}, {1, 0}, {1, 1}, {1, 2} },    // [1][2][3]
+        { {1, 2}, {2, 1}, {1, 1}, {0, 1} },
+        { {0, 1}, {1, 2}, {1, 1}, {1, 0} },
+    },
+    [Z] = {
+        { {0, 0}, {1, 0}, {1, 1}, {2, 1} },    // [0][1]
+        { {2, 0}, {2, 1}, {1, 1}, {1, 2} },    //    [2][3]
+        { {2, 2}, {1, 2}, {1, 1}, {0, 1} },
+        { {0, 2}, {0, 1}, {1, 1}, {1, 0} },
+    },
+};
+
+/* The row masks of each block type for each rotation, computed from the cells.
+   A line of the map is hit by the tetromino if (rows[i] << column) & line != 0. */
+static const PieceShape shapes[B_MAX][NB_ROTATIONS] = {
+    [I] = {
+        { 0, 1, 4, 1, { 0xF, 0x0, 0x0, 0x0 } },
+        { 2, 0, 1, 4, { 0x1, 0x1, 0x1, 0x1 } },
+        { 0, 2, 4, 1, { 0xF, 0x0, 0x0, 0x0 } },
+        { 1, 0, 1, 4, { 0x1, 0x1, 0x1, 0x1 } },
+    },
+    [J] = {
+        { 0, 0, 3, 2, { 0x1, 0x7, 0x0, 0x0 } },
+        { 1, 0, 2, 3, { 0x3, 0x1, 0x1, 0x0 } },
+        { 0, 1, 3, 2, { 0x7, 0x4, 0x0, 0x0 } },
+        { 0, 0, 2, 3, { 0x2, 0x2, 0x3, 0x0 } },
+    },
+    [L] = {
+        { 0, 0, 3, 2, { 0x4, 0x7, 0x0, 0x0 } },
+        { 1, 0, 2, 3, { 0x1, 0x1, 0x3, 0x0 } },
+        { 0, 1, 3, 2, { 0x7, 0x1, 0x0, 0x0 } },
+        { 0, 0, 2, 3, { 0x3, 0x2, 0x2, 0x0 } },
+    },
+    [O] = {
+        { 1, 0, 2, 2, { 0x3, 0x3, 0x0, 0x0 } },
+        { 1, 0, 2, 2, { 0x3, 0x3, 0x0, 0x0 } },
+        { 1, 0, 2, 2, { 0x3, 0x3, 0x0, 0x0 } },
+        { 1, 0, 2, 2, { 0x3, 0x3, 0x0, 0x0 } },
+    },
+    [S] = {
+        { 0, 0, 3, 2, { 0x6, 0x3, 0x0, 0x0 } },
+        { 1, 0, 2, 3, { 0x1, 0x3, 0x2, 0x0 } },
+        { 0, 1, 3, 2, { 0x6, 0x3, 0x0, 0x0 } },
+        { 0, 0, 2, 3, { 0x1, 0x3, 0x2, 0x0 } },
+    },
+    [T] = {
+        { 0, 0, 3, 2, { 0x2, 0x7, 0x0, 0x0 } },
+        { 1, 0, 2, 3, { 0x1, 0x3, 0x1, 0x0 } },
+        { 0, 1, 3, 2, { 0x7, 0x2, 0x0, 0x0 } },
+        { 0, 0, 2, 3, { 0x2, 0x3, 0x2, 0x0 } },
+    },
+    [Z] = {
+        { 0, 0, 3, 2, { 0x3, 0x6, 0x0, 0x0 } },
+        { 1, 0, 2, 3, { 0x2, 0x3, 0x1, 0x0 } },
+        { 0, 1, 3, 2, { 0x3, 0x6, 0x0, 0x0 } },
+        { 0, 0, 2, 3, { 0x2, 0x3, 0x1, 0x0 } },
+    },
+};
+
+/* The wall kicks of the Super Rotation System for a clockwise rotation from each state,
+   the offsets are tested in order and the first one not colliding is used (y goes down). */
+static const Square kicks[2][NB_ROTATIONS][NB_KICKS] = {
+    {   // J, L, O, S, T, Z
+        { {0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2} },  // 0 -> 1
+        { {0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2} },    // 1 -> 2
+        { {0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2} },     // 2 -> 3
+        { {0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2} }, // 3 -> 0
+    },
+    {   // I
+        { {0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2} },   // 0 -> 1
+        { {0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1} },   // 1 -> 2
+        { {0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2} },   // 2 -> 3
+        { {0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1} },   // 3 -> 0
+    },
+};
 
 
 /**
- * Create a tetromino with a certain block type and a color.
- * 
- * \param block type the block type of the tetromino.
- * \param color the color of the tetromino.
- * \return a new tetromino.
+ * Get a tetromino of a certain block type in its spawn position.
+ *
+ * \param block_type the block type of the tetromino, B_NONE for no tetromino.
+ * \return the new tetromino.
 */
-Tetromino* create_tetromino(BlockType block_type) 
+Tetromino spawn_tetromino(BlockType block_type)
 {
-    Tetromino* tetromino = malloc(sizeof(Tetromino));
-    if (tetromino == NULL)
-        return NULL;
-    tetromino->block_type = block_type;
-    tetromino->color = get_color_for_block_type(block_type);
-    tetromino->squares = create_squares(block_type);
-    tetromino->nb_squares = NB_SQUARES;
-    tetromino->blocked = false;
-    tetromino->rotation = 0;
+    Tetromino tetromino;
+    if (block_type >= B_MAX)
+    {
+        print_color("Blocktype not implemented", TXT_RED);
+        block_type = B_NONE;
+    }
+    tetromino.block_type = block_type;
+    tetromino.color = block_type == B_NONE ? C_NONE : get_color_for_block_type(block_type);
+    tetromino.blocked = false;
+    tetromino.rotation = 0;
+    tetromino.x = SPAWN_X;
+    tetromino.y = SPAWN_Y;
     return tetromino;
 }
 
 
 /**
- * Properly clean a tetromino.
- * 
- * \param tetromino the tetromino to be cleaned.
+ * Get the cells of the tetromino for its rotation, relative to its origin.
+ *
+ * \param tetromino the tetromino concerned.
+ * \return the NB_SQUARES cells of the tetromino.
 */
-void clean_tetromino(Tetromino** tetromino) 
+const Square* get_tetromino_cells(const Tetromino* tetromino)
 {
-    for(uint8_t i = 0; i < (*tetromino)->nb_squares; i++)
-        free((*tetromino)->squares[i]);
-    free((*tetromino)->squares);
+    return cells[tetromino->block_type][tetromino->rotation];
+}
+
+
+/**
+ * Get the position of a square of the tetromino in the map.
+ *
+ * \param tetromino the tetromino concerned.
+ * \param index the index of the square.
+ * \return the coordinates of the square.
+*/
+Square get_tetromino_square(const Tetromino* tetromino, uint8_t index)
+{
+    Square cell = cells[tetromino->block_type][tetromino->rotation][index];
+    Square square = { tetromino->x + cell.x, tetromino->y + cell.y };
+    return square;
+}
+
 
-    free((*tetromino));
-    *tetromino = NULL;
+/**
+ * Get the row masks of the tetromino for its rotation.
+ *
+ * \param tetromino the tetromino concerned.
+ * \return the shape of the tetromino.
+*/
+const PieceShape* get_tetromino_shape(const Tetromino* tetromino)
+{
+    return &shapes[tetromino->block_type][tetromino->rotation];
 }
 
 
 /**
- * Create a new random tetromino with a random block type and a random color.
+ * Get the wall kicks to test for a clockwise rotation of the tetromino from its rotation.
  *
- * \return the new random tetromino.
+ * \param tetromino the tetromino concerned.
+ * \return the NB_KICKS offsets to test in order.
 */
-Tetromino* get_random_tetromino()
+const Square* get_rotation_kicks(const Tetromino* tetromino)
 {
-    uint8_t block_type = (rand() % (B_MAX - 1)) + 1;
-    return create_tetromino(block_type);
+    return kicks[tetromino->block_type == I][tetromino->rotation];
 }
 
 
@@ -78,31 +201,16 @@ Tetromino* get_random_tetromino()
 */
 bool square_in_tetromino(const Tetromino* tetromino, const int8_t x, const int8_t y)
 {
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
+    const Square* tetromino_cells = get_tetromino_cells(tetromino);
+    for(uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        Square* square = tetromino->squares[i];
-        if(square->x == x && square->y == y)
+        if(tetromino->x + tetromino_cells[i].x == x && tetromino->y + tetromino_cells[i].y == y)
             return true;
     }
     return false;
 }
 
 
-/**
- * Check if the tetromino is dead, mean that all the squares in the tetromino are dead.
- * 
- * \param tetromino the tetromino to be checked.
- * \return true if all the squares in this tetromino are dead, false else.
-*/
-bool tetromino_is_dead(const Tetromino* tetromino) 
-{
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++) 
-        if (tetromino->squares[i]->alive)
-            return false;
-    return true;
-}
-
-
 /**
  * Compare two tetrominos and return if there are the same.
  * 
@@ -112,84 +220,8 @@ bool tetromino_is_dead(const Tetromino* tetromino)
 */
 bool same_tetrominos(const Tetromino* t1, const Tetromino* t2) 
 {
-    if ((t1->blocked != t2->blocked) || (t1->rotation != t2->rotation) || (t1->block_type != t2->block_type))
-        return false;
-
-    for (uint8_t i = 0; i < t1->nb_squares; i++)
-    {
-        Square* s1 = t1->squares[i];
-        Square* s2 = t2->squares[i];
-        if (s1->x != s2->x || s1->y != s2->y)
-            return false;
-    }
-
-    return true;
-}
-
-
-/**
- * Create a square with a given x and y.
- *
- * \param x the abciss of the square, the colum in the map
- * \param y the ordinate of the square, the line in the map
- * \return a new square which is per default alive.
-*/
-Square* create_square(int8_t x, int8_t y)
-{
-    Square* square = malloc(sizeof(Square));
-    square->x = x;
-    square->y = y;
-    square->alive = true;
-    return square;
-}
-
-
-/**
- * Create all squares for a tetromino for a certain block type.
- *
- * \param block_type the block type of the tetromino.
- * \return all the squares for a tetromino.
-*/
-Square** create_squares(BlockType block_type)
-{
-    Square** squares = malloc(NB_SQUARES * sizeof(Square*));
-    switch (block_type)
-    {
-    case I:
-        squares[0] = create_square(3, -2); squares[1] = create_square(4, -2); // [0][1][2][3]
-        squares[2] = create_square(5, -2); squares[3] = create_square(6, -2);
-        break;
-    case J:
-        squares[0] = create_square(3, -3); squares[1] = create_square(4, -3); // [0][1][2]
-        squares[2] = create_square(5, -3); squares[3] = create_square(5, -2); //       [3]
-        break;
-    case L:
-        squares[0] = create_square(3, -3); squares[1] = create_square(4, -3); // [0][1][2]
-        squares[2] = create_square(5, -3); squares[3] = create_square(3, -2); // [3]
-        break;
-    case O:
-        squares[0] = create_square(4, -3); squares[1] = create_square(5, -3); // [0][1]
-        squares[2] = create_square(4, -2); squares[3] = create_square(5, -2); // [2][3]
-        break;
-    case S:
-        squares[0] = create_square(4, -3); squares[1] = create_square(5, -3); //    [0][1]
-        squares[2] = create_square(3, -2); squares[3] = create_square(4, -2); // [2][3]
-        break;
-    case T:
-        squares[0] = create_square(3, -3); squares[1] = create_square(4, -3); // [0][1][2]
-        squares[2] = create_square(5, -3); squares[3] = create_square(4, -2); //    [3]   
-        break;
-    case Z:
-        squares[0] = create_square(3, -3); squares[1] = create_square(4, -3); // [0][1]
-        squares[2] = create_square(4, -2); squares[3] = create_square(5, -2); //    [2][3]
-        break;
-    case B_NONE:
-    case B_MAX:
-    default:
-        print_color("Blocktype not implemented", TXT_RED);
-        break;
-    }
-    return squares;
+    return t1->blocked == t2->blocked && t1->rotation == t2->rotation && t1->block_type == t2->block_type
+        && t1->x == t2->x && t1->y == t2->y;
 }
 
 
@@ -236,7 +268,7 @@ Color get_color_for_block_type(BlockType block_type)
 
 
 /**
- * Get the number of rotation for that particular block type.
+ * Get the number of rotations with a different shape for that particular block type.
  * 
  * \return the number of rotation for that block type.
 */
@@ -264,53 +296,8 @@ uint8_t get_number_of_rotation(BlockType block_type)
 
 
 /**
- * Get the next rotation additions to all the squares for that tetromino.
- * 
- * \param tetromino the tetromino to get the next rotation.
- * \return [nb_squares][2] array that contains the moves for all the squares.
-*/
-int8_t** get_next_rotation_moves(Tetromino* tetromino)
-{
-    int8_t** moves = malloc(sizeof(int8_t*) * NB_SQUARES);
-    for (uint8_t i = 0; i < NB_SQUARES; i++)
-        moves[i] = calloc(2, sizeof(int8_t));
-
-    switch(tetromino->block_type) 
-    {
-        case I:
-            fill_moves_for_I(tetromino->rotation, moves);
-            break;
-        case J:
-            fill_moves_for_J(tetromino->rotation, moves);
-            break;
-        case L:
-            fill_moves_for_L(tetromino->rotation, moves);
-            break;
-        case O:
-            //fill_moves_for_O(tetromino->rotation, moves);
-            break;
-        case S:
-            fill_moves_for_S(tetromino->rotation, moves);
-            break;
-        case T:
-            fill_moves_for_T(tetromino->rotation, moves);
-            break;
-        case Z:
-            fill_moves_for_Z(tetromino->rotation, moves);
-            break;
-        case B_NONE:
-        case B_MAX:
-        default:
-            print_color("get_next_rotation_moves => block_type undefined", TXT_RED);
-            break;
-    }
-
-    return moves;
-}
-
-
-/**
- * Update the actual rotation of the tetromino to the next rotation.
+ * Update the actual rotation of the tetromino to the next clockwise rotation.
+ * The origin does not change, the wall kicks are applied by the board.
 */
 void update_rotation(Tetromino* tetromino) 
 {
@@ -319,8 +306,6 @@ void update_rotation(Tetromino* tetromino)
         case Z:
         case S:
         case I:
-            tetromino->rotation = (tetromino->rotation + 1) % 2; // 2 states
-            break;
         case J:
         case L:
         case T:
@@ -335,123 +320,3 @@ void update_rotation(Tetromino* tetromino)
             break;
     }
 }
-
-
-void fill_moves_for_I(uint8_t rotation, int8_t** moves)
-{
-    if (rotation == 0)
-    {																		   // [0]
-        moves[0][0] = 1; moves[0][1] = -1; // 2nd square stay				   // [1]
-        moves[2][0] = -1; moves[2][1] = 1; moves[3][0] = -2; moves[3][1] = 2;  // [2]
-    }																		   // [3]
-    else 
-    {
-        moves[0][0] = -1; moves[0][1] = 1; // 2nd square stay				   // [0][1][2][3]
-        moves[2][0] = 1; moves[2][1] = -1; moves[3][0] = 2; moves[3][1] = -2; 
-    }
-}
-
-void fill_moves_for_J(uint8_t rotation, int8_t** moves)
-{
-    if(rotation == 0)
-    {																		   //    [0]
-        moves[0][0] = 1; moves[0][1] = -1; // 2nd square stay				   //    [1] 
-        moves[2][0] = -1; moves[2][1] = 1; moves[3][0] = -2; moves[3][1] = 0;  // [3][2]
-    }
-    else if(rotation == 1)
-    {
-        moves[0][0] = 1; moves[0][1] = 1; // 2nd square stay				   // [3]
-        moves[2][0] = -1; moves[2][1] = -1; moves[3][0] = 0; moves[3][1] = -2; // [2][1][0]
-    }
-    else if(rotation == 2) 
-    {																		   // [2][3]
-        moves[0][0] = -1; moves[0][1] = 1; // 2nd square stay				   // [1]
-        moves[2][0] = 1; moves[2][1] = -1; moves[3][0] = 2; moves[3][1] = 0;   // [0]
-    }
-    else 
-    {
-        moves[0][0] = -1; moves[0][1] = -1; // 2nd square stay				   // [0][1][2]
-        moves[2][0] = 1; moves[2][1] = 1; moves[3][0] = 0; moves[3][1] = 2;    //       [3]
-    }
-}
-
-void fill_moves_for_L(uint8_t rotation, int8_t** moves)
-{
-    if(rotation == 0) 
-    {																		   // [3][0]
-        moves[0][0] = 1; moves[0][1] = -1; // 2nd square stay				   //    [1] 
-        moves[2][0] = -1; moves[2][1] = 1; moves[3][0] = 0; moves[3][1] = -2;  //    [2]
-    }
-    else if(rotation == 1)
-    {
-        moves[0][0] = 1; moves[0][1] = 1; // 2nd square stay				   //       [3] 
-        moves[2][0] = -1; moves[2][1] = -1; moves[3][0] = 2; moves[3][1] = 0;  // [2][1][0]
-    }
-    else if(rotation == 2) 
-    {																		   // [2]
-        moves[0][0] = -1; moves[0][1] = 1; // 2nd square stay				   // [1] 
-        moves[2][0] = 1; moves[2][1] = -1; moves[3][0] = 0; moves[3][1] = 2;   // [0][3]
-    }
-    else 
-    {
-        moves[0][0] = -1; moves[0][1] = -1; // 2nd square stay				   // [0][1][2]
-        moves[2][0] = 1; moves[2][1] = 1; moves[3][0] = -2; moves[3][1] = 0;   // [3]
-    }
-}
-
-/*void fill_moves_for_O(uint8_t rotation, int8_t** moves)
-{  
-    // Nothing to do lol
-}*/
-
-void fill_moves_for_S(uint8_t rotation, int8_t** moves)
-{
-    if (rotation == 0)
-    {																		   // [2]
-        moves[0][0] = 1; moves[0][1] = 0; moves[1][0] = 0; moves[1][1] = 1;    // [3][0] 
-        moves[2][0] = 1; moves[2][1] = -2; moves[3][0] = 0; moves[3][1] = -1;  //    [1]
-    }
-    else
-    {
-        moves[0][0] = -1; moves[0][1] = 0; moves[1][0] = 0; moves[1][1] = -1;  //    [0][1] 
-        moves[2][0] = -1; moves[2][1] = 2; moves[3][0] = 0; moves[3][1] = 1;  // [2][3]
-    }
-}
-
-void fill_moves_for_T(uint8_t rotation, int8_t** moves)
-{
-    if (rotation == 0)
-    {																		   //    [0]
-        moves[0][0] = 2; moves[0][1] = 0; moves[1][0] = 1; moves[1][1] = 1;    // [3][1] 
-        moves[2][0] = 0; moves[2][1] = 2; // 3rd square stay				   //    [2]
-    }
-    else if (rotation == 1)
-    {
-        moves[0][0] = 0; moves[0][1] = 2; moves[1][0] = -1; moves[1][1] = 1;   //    [3] 
-        moves[2][0] = -2; moves[2][1] = 0; // 3rd square stay				   // [2][1][0]
-    }
-    else if (rotation == 2)
-    {																		   // [0]
-        moves[0][0] = -2; moves[0][1] = 0; moves[1][0] = -1; moves[1][1] = -1; // [1][3] 
-        moves[2][0] = 0; moves[2][1] = -2; // 3rd square stay				   // [2]
-    }
-    else
-    {
-        moves[0][0] = 0; moves[0][1] = -2; moves[1][0] = 1; moves[1][1] = -1;   // [0][1][2]
-        moves[2][0] = 2; moves[2][1] = 0; // 3rd square stay				    //    [3]
-    }
-}
-
-void fill_moves_for_Z(uint8_t rotation, int8_t** moves)
-{
-    if (rotation == 0)
-    {																		   //    [0]
-        moves[0][0] = 1; moves[0][1] = -1; // 2nd square stay				   // [2][1] 
-        moves[2][0] = -1; moves[2][1] = -1; moves[3][0] = -2; moves[3][1] = 0; // [3]
-    }
-    else
-    {
-        moves[0][0] = -1; moves[0][1] = 1; // 2nd square stay                  // [0][1] 
-        moves[2][0] = 1; moves[2][1] = 1; moves[3][0] = 2; moves[3][1] = 0;    //    [2][3]
-    }
-}
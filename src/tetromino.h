@@ -1,12 +1,14 @@
 #ifndef TETROMINO_H
 #define TETROMINO_H
 
-#include <SDL2/SDL.h>
-
 #include <stdint.h>
 #include <stdbool.h>
 
 #define NB_SQUARES 4
+#define NB_ROTATIONS 4
+#define NB_KICKS 5 // The number of offsets tested for a rotation
+#define SPAWN_X 3  // The origin of a new tetromino
+#define SPAWN_Y -3
 
 typedef enum Color {
 	C_NONE,
@@ -35,28 +37,31 @@ typedef enum BlockType {
 
 typedef struct Square {
 	int8_t x, y;
-	bool alive;
 } Square;
 
+typedef struct PieceShape {
+	int8_t left, top;          // The offset of the leftmost column and of the top line from the origin
+	uint8_t width, height;     // The number of columns and lines covered
+	uint16_t rows[NB_SQUARES]; // The occupancy mask of each line from the top, the bit 0 is the leftmost column
+} PieceShape;
+
 typedef struct Tetromino {
-	Square** squares;
-	uint8_t nb_squares;
+	BlockType block_type; // B_NONE if there is no tetromino
 	Color color;
-	BlockType block_type;
 	bool blocked;
-	uint8_t rotation;
+	uint8_t rotation;     // The rotation state, the index of the cells in the rotation table
+	int8_t x, y;          // The origin of the cells in the map
 } Tetromino;
 
-Tetromino* create_tetromino(BlockType block_type);
-void clean_tetromino(Tetromino** tetromino);
-
-Tetromino* get_random_tetromino();
+Tetromino spawn_tetromino(BlockType block_type);
+const Square* get_tetromino_cells(const Tetromino* tetromino);
+Square get_tetromino_square(const Tetromino* tetromino, uint8_t index);
+const PieceShape* get_tetromino_shape(const Tetromino* tetromino);
+const Square* get_rotation_kicks(const Tetromino* tetromino);
 bool square_in_tetromino(const Tetromino* tetromino, const int8_t x, const int8_t y);
-bool tetromino_is_dead(const Tetromino* tetromino);
 bool same_tetrominos(const Tetromino* tetromino1, const Tetromino* tetromino2);
 Color get_color_for_block_type(BlockType block_type);
 uint8_t get_number_of_rotation(BlockType block_type);
-int8_t** get_next_rotation_moves(Tetromino* tetromino);
 void update_rotation(Tetromino* tetromino);
 
 #endif // TETROMINO_H
@@ -75,6 +75,95 @@ void draw_text(Text* text, SDL_Renderer* renderer)
 }
 
 
+/**
+ * Create a new number text, it stays centered when its number of digits changes.
+ *
+ * \param value the number shown.
+ * \param x the x position of a number with one digit.
+ * \param y the y position of the text.
+ * \param size the size of each digit in pixel (width and height).
+ * \return a new NumberText struct.
+*/
+NumberText* create_number_text(uint32_t value, int16_t x, int16_t y, uint8_t size)
+{
+	NumberText* text = malloc(sizeof(NumberText));
+	if (text == NULL)
+		return NULL;
+	text->size = size;
+	text->correction = TEXT_CORRECTION * size;
+	text->visible = true;
+	text->x = x;
+	text->pos.y = y;
+	text->pos.h = size;
+	text->nb_digits = 0;
+	text->value = ~value;
+	set_number_text(text, value);
+	return text;
+}
+
+
+/**
+ * Correctly clean a NumberText object.
+*/
+void clean_number_text(NumberText** text)
+{
+	free((*text));
+	*text = NULL;
+}
+
+
+/**
+ * Change the number shown by the text, its digits and glyphs are computed again only if it changed.
+ *
+ * \param text the text concerned.
+ * \param value the new number.
+*/
+void set_number_text(NumberText* text, uint32_t value)
+{
+	if (value == text->value)
+		return;
+	text->value = value;
+
+	// The digits are written from the last one
+	char digits[NUMBER_TEXT_MAX_DIGITS];
+	uint8_t nb_digits = 0;
+	do
+	{
+		digits[NUMBER_TEXT_MAX_DIGITS - 1 - nb_digits] = '0' + value % 10;
+		nb_digits++;
+		value /= 10;
+	} while (value);
+	memcpy(text->digits, digits + NUMBER_TEXT_MAX_DIGITS - nb_digits, nb_digits);
+	text->nb_digits = nb_digits;
+
+	const uint8_t advance = text->size - text->correction;
+	text->pos.x = text->x - (text->size * NUMBER_TEXT_SHIFT) * (nb_digits - 1);
+	text->pos.w = nb_digits * advance;
+	for (uint8_t i = 0; i < nb_digits; i++)
+	{
+		SDL_Rect position = { text->pos.x + i * advance, text->pos.y, text->size, text->size };
+		text->glyphs[i] = g_chars[text->digits[i] - CHAR_OFFSET];
+		text->glyphs_pos[i] = position;
+	}
+}
+
+
+/**
+ * Draw in the renderer the glyph run of the number text.
+ *
+ * \param text the text to be drawed.
+ * \param renderer the renderer of the window.
+*/
+void draw_number_text(const NumberText* text, SDL_Renderer* renderer)
+{
+	if (!text->visible)
+		return;
+
+	for (uint8_t i = 0; i < text->nb_digits; i++)
+		SDL_RenderCopy(renderer, text->glyphs[i], NULL, &text->glyphs_pos[i]);
+}
+
+
 /**
  * Create a new key_text object. A key text object represent a texture of a key
  * with a text associate with it.
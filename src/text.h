@@ -3,6 +3,8 @@
 
 #define TEXT_CORRECTION 0.3f // More is less space between letters
 #define SPACE_BETWEEN_KEY_TEXT 10
+#define NUMBER_TEXT_MAX_DIGITS 10 // The digits of the biggest uint32_t
+#define NUMBER_TEXT_SHIFT 0.32f // The part of the size the number goes left for each digit added, to stay centered
 
 #include <SDL2/SDL.h>
 
@@ -17,6 +19,20 @@ typedef struct Text {
 	bool visible;
 } Text;
 
+/* A text showing a number, the glyphs of its digits are only computed when the value changes. */
+typedef struct NumberText {
+	SDL_Rect pos;
+	uint32_t value;
+	char digits[NUMBER_TEXT_MAX_DIGITS];              // The digits of the value, not ended by '\0'
+	uint8_t nb_digits;
+	SDL_Texture* glyphs[NUMBER_TEXT_MAX_DIGITS];      // The glyph run : the texture and position of each digit
+	SDL_Rect glyphs_pos[NUMBER_TEXT_MAX_DIGITS];
+	int16_t x;                                        // The position of a number with one digit
+	uint8_t size;
+	uint8_t correction;
+	bool visible;
+} NumberText;
+
 typedef struct KeyText {
 	SDL_Rect pos;
 	SDL_Texture* texture;
@@ -28,6 +44,11 @@ Text* create_text(char* text, int16_t x, int16_t y, uint8_t size);
 void clean_text(Text** text);
 void draw_text(Text* text, SDL_Renderer* renderer);
 
+NumberText* create_number_text(uint32_t value, int16_t x, int16_t y, uint8_t size);
+void clean_number_text(NumberText** text);
+void set_number_text(NumberText* text, uint32_t value);
+void draw_number_text(const NumberText* text, SDL_Renderer* renderer);
+
 KeyText* create_key_text(SDL_Texture* key_texture, char* text, SDL_Rect pos, uint8_t text_size);
 void clean_key_text(KeyText** key_text);
 void draw_key_text(KeyText* key_text, SDL_Renderer* renderer);
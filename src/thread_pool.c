@@ -0,0 +1,278 @@
+#include "thread_pool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "threads.h"
+#include "print_color.h"
+
+/* A worker of the pool and the tasks it has left. The tasks are taken from the beginning by the worker
+   and stolen from the end by the others. */
+typedef struct Worker {
+    ThreadPool* pool;    // The pool of the worker
+    uint8_t index;       // The index of the worker, 0 is the thread running the batches
+    Thread thread;       // The thread of the worker, unused for the worker 0
+    Mutex mutex;         // Protects the tasks left
+    uint32_t begin, end; // The tasks left
+} Worker;
+
+struct ThreadPool {
+    uint8_t nb_workers;           // The number of workers, the calling thread included
+    Worker workers[MAX_THREADS];
+    Mutex mutex;                  // Protects the fields below
+    Condition start;              // Signaled when a batch starts or when the pool stops
+    Condition done;               // Signaled when the last thread finished the batch
+    PoolTask task;                // The function of the tasks of the batch
+    void* context;                // The context given to the tasks
+    uint32_t batch;               // The number of batches started
+    uint8_t working;              // The number of threads still running the batch, the calling thread excluded
+    bool stop;                    // If the threads must stop
+};
+
+/* Thread pool functions declaration */
+THREAD_FUNCTION(run_worker, data);
+void run_tasks(Worker* worker);
+bool take_task(Worker* worker, uint32_t* task);
+bool steal_task(Worker* worker, uint32_t* task);
+
+
+/* #################### PUBLIC #################### */
+
+/**
+ * Create a thread pool and start its threads.
+ * If a thread can't be started, the pool keeps the workers started before it.
+ *
+ * \param nb_workers the number of workers, the thread running the batches included, between 1 and MAX_THREADS.
+ * \return the thread pool, NULL if it can't be allocated.
+*/
+ThreadPool* create_thread_pool(uint8_t nb_workers)
+{
+    ThreadPool* pool = malloc(sizeof(ThreadPool));
+    if (pool == NULL)
+        return NULL;
+    pool->nb_workers = nb_workers < 1 ? 1 : nb_workers > MAX_THREADS ? MAX_THREADS : nb_workers;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->batch = 0;
+    pool->working = 0;
+    pool->stop = false;
+    init_mutex(&pool->mutex);
+    init_condition(&pool->start);
+    init_condition(&pool->done);
+
+    for (uint8_t i = 0; i < pool->nb_workers; i++)
+    {
+        Worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->begin = 0;
+        worker->end = 0;
+        init_mutex(&worker->mutex);
+        if (i > 0 && !start_thread(&worker->thread, &run_worker, worker))
+        {
+            print_color("Error starting a thread of the pool", TXT_RED);
+            destroy_mutex(&worker->mutex);
+            pool->nb_workers = i;
+        }
+    }
+    return pool;
+}
+
+
+/**
+ * Stop the threads and free a thread pool.
+ *
+ * \param pool the pointer of pointer of the thread pool.
+*/
+void clean_thread_pool(ThreadPool** pool)
+{
+    ThreadPool* _pool = *pool;
+    lock_mutex(&_pool->mutex);
+    _pool->stop = true;
+    broadcast_condition(&_pool->start);
+    unlock_mutex(&_pool->mutex);
+
+    for (uint8_t i = 0; i < _pool->nb_workers; i++)
+    {
+        Worker* worker = &_pool->workers[i];
+        if (i > 0)
+            join_thread(worker->thread);
+        destroy_mutex(&worker->mutex);
+    }
+    destroy_condition(&_pool->start);
+    destroy_condition(&_pool->done);
+    destroy_mutex(&_pool->mutex);
+    free(_pool);
+    *pool = NULL;
+}
+
+
+/**
+ * Run a batch of tasks on the workers and wait for all of them, the calling thread works too.
+ * The tasks can end in any order, a task must only write its own results to stay deterministic.
+ *
+ * \param pool the thread pool, only one batch runs at a time.
+ * \param task the function run for each task.
+ * \param context the context given to the tasks.
+ * \param nb_tasks the number of tasks, their indexes go from 0 to nb_tasks - 1.
+*/
+void run_thread_pool(ThreadPool* pool, PoolTask task, void* context, uint32_t nb_tasks)
+{
+    if (pool->nb_workers == 1)
+    {
+        for (uint32_t i = 0; i < nb_tasks; i++)
+            task(context, i, 0);
+        return;
+    }
+
+    // Each worker starts with a contiguous part of the tasks, the threads are waiting so no lock is needed
+    for (uint8_t i = 0; i < pool->nb_workers; i++)
+    {
+        pool->workers[i].begin = (uint64_t) nb_tasks * i / pool->nb_workers;
+        pool->workers[i].end = (uint64_t) nb_tasks * (i + 1) / pool->nb_workers;
+    }
+
+    lock_mutex(&pool->mutex);
+    pool->task = task;
+    pool->context = context;
+    pool->working = pool->nb_workers - 1;
+    pool->batch++;
+    broadcast_condition(&pool->start);
+    unlock_mutex(&pool->mutex);
+
+    run_tasks(&pool->workers[0]);
+
+    lock_mutex(&pool->mutex);
+    while (pool->working > 0)
+        wait_condition(&pool->done, &pool->mutex);
+    unlock_mutex(&pool->mutex);
+}
+
+
+/**
+ * Get the number of workers of a thread pool.
+ *
+ * \param pool the thread pool concerned.
+ * \return the number of workers, the thread running the batches included.
+*/
+uint8_t get_thread_pool_size(const ThreadPool* pool)
+{
+    return pool->nb_workers;
+}
+
+
+/**
+ * Get the number of cores of the computer.
+ *
+ * \return the number of cores available, between 1 and MAX_THREADS.
+*/
+uint8_t get_number_of_cores(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long cores = (long) info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return cores < 1 ? 1 : cores > MAX_THREADS ? MAX_THREADS : (uint8_t) cores;
+}
+
+
+/* #################### PRIVATE #################### */
+
+/**
+ * The loop of a thread of the pool, it runs the tasks of each batch until the pool stops.
+ *
+ * \param data the worker of the thread.
+ * \return nothing.
+*/
+THREAD_FUNCTION(run_worker, data)
+{
+    Worker* worker = data;
+    ThreadPool* pool = worker->pool;
+    uint32_t batch = 0;
+
+    lock_mutex(&pool->mutex);
+    while (true)
+    {
+        while (!pool->stop && pool->batch == batch)
+            wait_condition(&pool->start, &pool->mutex);
+        if (pool->stop)
+            break;
+        batch = pool->batch;
+        unlock_mutex(&pool->mutex);
+
+        run_tasks(worker);
+
+        lock_mutex(&pool->mutex);
+        if (--pool->working == 0)
+            signal_condition(&pool->done);
+    }
+    unlock_mutex(&pool->mutex);
+    return 0;
+}
+
+
+/**
+ * Run the tasks of a worker, then the tasks stolen from the others until there is none left.
+ *
+ * \param worker the worker concerned.
+*/
+void run_tasks(Worker* worker)
+{
+    ThreadPool* pool = worker->pool;
+    uint32_t task;
+    while (take_task(worker, &task) || steal_task(worker, &task))
+        pool->task(pool->context, task, worker->index);
+}
+
+
+/**
+ * Take the first task left by a worker.
+ *
+ * \param worker the worker concerned.
+ * \param task the index of the task taken.
+ * \return false if the worker has no task left.
+*/
+bool take_task(Worker* worker, uint32_t* task)
+{
+    lock_mutex(&worker->mutex);
+    const bool found = worker->begin < worker->end;
+    if (found)
+        *task = worker->begin++;
+    unlock_mutex(&worker->mutex);
+    return found;
+}
+
+
+/**
+ * Steal the last task left by another worker, starting with the next worker.
+ *
+ * \param worker the worker stealing.
+ * \param task the index of the task stolen.
+ * \return false if no worker has a task left.
+*/
+bool steal_task(Worker* worker, uint32_t* task)
+{
+    ThreadPool* pool = worker->pool;
+    for (uint8_t i = 1; i < pool->nb_workers; i++)
+    {
+        Worker* victim = &pool->workers[(worker->index + i) % pool->nb_workers];
+        lock_mutex(&victim->mutex);
+        const bool found = victim->begin < victim->end;
+        if (found)
+            *task = --victim->end;
+        unlock_mutex(&victim->mutex);
+        if (found)
+            return true;
+    }
+    return false;
+}
+
@@ -0,0 +1,22 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#define MAX_THREADS 64 // The most workers of a pool, the calling thread included
+
+#include <stdint.h>
+
+/* The function run for each task, with the index of the task and the index of the worker running it. */
+typedef void (*PoolTask)(void* context, uint32_t task, uint8_t worker);
+
+/* Workers running batches of tasks. Each worker starts with its own part of the tasks
+   and takes the tasks left by the others when it has finished, so uneven tasks stay balanced.
+   The platform threads are hidden in thread_pool.c (pthreads, or the Windows threads). */
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool* create_thread_pool(uint8_t nb_workers);
+void clean_thread_pool(ThreadPool** pool);
+void run_thread_pool(ThreadPool* pool, PoolTask task, void* context, uint32_t nb_tasks);
+uint8_t get_thread_pool_size(const ThreadPool* pool);
+uint8_t get_number_of_cores(void);
+
+#endif // THREAD_POOL_H
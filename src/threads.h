@@ -0,0 +1,45 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+/* The threads of the platform : pthreads, or the Windows threads with _WIN32.
+   Only included by the translation units of the core which start threads. */
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+#define THREAD_FUNCTION(name, data) DWORD WINAPI name(void* data)
+#define start_thread(thread, function, data) ((*(thread) = CreateThread(NULL, 0, function, data, 0, NULL)) != NULL)
+#define join_thread(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+#define init_mutex(mutex) InitializeCriticalSection(mutex)
+#define destroy_mutex(mutex) DeleteCriticalSection(mutex)
+#define lock_mutex(mutex) EnterCriticalSection(mutex)
+#define try_lock_mutex(mutex) (TryEnterCriticalSection(mutex) != 0)
+#define unlock_mutex(mutex) LeaveCriticalSection(mutex)
+#define init_condition(condition) InitializeConditionVariable(condition)
+#define destroy_condition(condition) ((void) (condition))
+#define wait_condition(condition, mutex) SleepConditionVariableCS(condition, mutex, INFINITE)
+#define signal_condition(condition) WakeConditionVariable(condition)
+#define broadcast_condition(condition) WakeAllConditionVariable(condition)
+#else
+#include <pthread.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+#define THREAD_FUNCTION(name, data) void* name(void* data)
+#define start_thread(thread, function, data) (pthread_create(thread, NULL, function, data) == 0)
+#define join_thread(thread) pthread_join(thread, NULL)
+#define init_mutex(mutex) pthread_mutex_init(mutex, NULL)
+#define destroy_mutex(mutex) pthread_mutex_destroy(mutex)
+#define lock_mutex(mutex) pthread_mutex_lock(mutex)
+#define try_lock_mutex(mutex) (pthread_mutex_trylock(mutex) == 0)
+#define unlock_mutex(mutex) pthread_mutex_unlock(mutex)
+#define init_condition(condition) pthread_cond_init(condition, NULL)
+#define destroy_condition(condition) pthread_cond_destroy(condition)
+#define wait_condition(condition, mutex) pthread_cond_wait(condition, mutex)
+#define signal_condition(condition) pthread_cond_signal(condition)
+#define broadcast_condition(condition) pthread_cond_broadcast(condition)
+#endif
+
+#endif // THREADS_H
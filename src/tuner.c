@@ -0,0 +1,352 @@
+#include "board.h"
+#include "ai.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include "evaluator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define TUNER_DELTA_T 16            // The fixed time step of a frame (ms)
+#define TUNER_MAX_FRAMES 2000000    // The number of frames before a game is stopped
+#define TUNER_MAX_POPULATION 256
+#define TUNER_MAX_GAMES 256         // The most games played by each candidate in a generation
+#define TUNER_ELITES 2              // The best candidates kept unchanged in the next generation
+#define TUNER_TOURNAMENT 3          // The number of candidates drawn to choose a parent, the best one wins
+#define TUNER_MUTATION_RATE 0.3f    // The probability of each weight of a child to mutate
+#define TUNER_MUTATION_SIGMA 0.15f  // The standard deviation of a mutation, the weights have a norm of 1
+#define TUNER_TAU 6.28318530717958647692
+
+/* The candidates of a generation and the scores of their games. */
+typedef struct Tuner {
+    AIWeights candidates[TUNER_MAX_POPULATION];
+    double fitness[TUNER_MAX_POPULATION];     // The average score of the games of each candidate
+    uint32_t scores[TUNER_MAX_POPULATION * TUNER_MAX_GAMES]; // The score of each game, written by its task only
+    uint16_t population;
+    uint16_t nb_games;                        // The games played by each candidate, with the same seeds for all of them
+    uint32_t first_seed;                      // The seed of the first game of the generation
+    Randomizer randomizer;
+    uint8_t beam_width;
+    uint8_t beam_depth;
+} Tuner;
+
+void tuner_full_callback();
+void play_tuner_game(void* context, uint32_t task, uint8_t worker);
+uint32_t play_game(const AIWeights* weights, uint32_t seed, Randomizer randomizer, uint8_t beam_width, uint8_t beam_depth);
+void sort_candidates(const Tuner* tuner, uint16_t* order);
+void breed_candidates(Tuner* tuner, const uint16_t* order, Rng* rng);
+uint16_t select_parent(const Tuner* tuner, Rng* rng);
+void mutate_weights(AIWeights* weights, float rate, Rng* rng);
+void normalize_weights(AIWeights* weights);
+float random_uniform(Rng* rng);
+float random_gaussian(Rng* rng);
+
+/**
+ * Tune the weights of the AI with a genetic algorithm, each candidate plays seeded games on all the cores.
+ * The best weights of each generation are written to AI_WEIGHTS_FILE next to the tuner, where the game and headless
+ * read them, they are also the start of the next run.
+ * usage : tuner [generations] [population] [games per candidate] [first seed] [uniform|bag] [beam width] [beam depth]
+ *               [number of threads]
+*/
+int main(int argc, char** argv)
+{
+    const uint32_t nb_generations = argc > 1 ? (uint32_t) atoi(argv[1]) : 20;
+    const int population = argc > 2 ? atoi(argv[2]) : 24;
+    const int nb_games = argc > 3 ? atoi(argv[3]) : 8;
+    const uint32_t seed = argc > 4 ? (uint32_t) atoi(argv[4]) : 1;
+    const Randomizer randomizer = argc > 5 && !strcmp(argv[5], "bag") ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+    const uint8_t beam_width = argc > 6 ? (uint8_t) atoi(argv[6]) : 1;
+    const uint8_t beam_depth = argc > 7 ? (uint8_t) atoi(argv[7]) : 1;
+    const uint8_t nb_threads = argc > 8 ? (uint8_t) atoi(argv[8]) : get_number_of_cores();
+    if (population <= TUNER_ELITES || population > TUNER_MAX_POPULATION || nb_games < 1 || nb_games > TUNER_MAX_GAMES)
+    {
+        printf("the population must be between %d and %d, the games between 1 and %d\n",
+            TUNER_ELITES + 1, TUNER_MAX_POPULATION, TUNER_MAX_GAMES);
+        return 1;
+    }
+
+    Tuner* tuner = malloc(sizeof(Tuner));
+    ThreadPool* pool = create_thread_pool(nb_threads);
+    if (tuner == NULL || pool == NULL)
+    {
+        printf("error creating the tuner\n");
+        free(tuner);
+        if (pool != NULL)
+            clean_thread_pool(&pool);
+        return 1;
+    }
+    tuner->population = (uint16_t) population;
+    tuner->nb_games = (uint16_t) nb_games;
+    tuner->randomizer = randomizer;
+    tuner->beam_width = beam_width;
+    tuner->beam_depth = beam_depth;
+
+    // The first generation is made around the weights of the last run, or the default ones
+    char weights_path[FILENAME_MAX];
+    if (!get_weights_path(argv[0], weights_path, sizeof(weights_path)))
+    {
+        printf("the path of the weights file is too long\n");
+        clean_thread_pool(&pool);
+        free(tuner);
+        return 1;
+    }
+    AIWeights start;
+    get_default_weights(&start);
+    if (load_weights(weights_path, &start))
+        printf("starting from the weights of %s\n", weights_path);
+    else
+        printf("starting from the default weights, they are written to %s\n", weights_path);
+    normalize_weights(&start);
+    Rng rng;
+    seed_rng(&rng, seed);
+    tuner->candidates[0] = start;
+    for (uint16_t i = 1; i < tuner->population; i++)
+    {
+        tuner->candidates[i] = start;
+        mutate_weights(&tuner->candidates[i], 1, &rng);
+    }
+    printf("%u generations of %u candidates playing %u games, on %u threads\n",
+        nb_generations, tuner->population, tuner->nb_games, get_thread_pool_size(pool));
+
+    uint16_t order[TUNER_MAX_POPULATION];
+    for (uint32_t generation = 0; generation < nb_generations; generation++)
+    {
+        struct timespec begin, end;
+        timespec_get(&begin, TIME_UTC);
+
+        // Each generation plays new games, so the weights don't learn a few seeds
+        tuner->first_seed = seed + generation * tuner->nb_games;
+        run_thread_pool(pool, &play_tuner_game, tuner, (uint32_t) tuner->population * tuner->nb_games);
+        double mean = 0;
+        for (uint16_t i = 0; i < tuner->population; i++)
+        {
+            uint64_t total = 0;
+            for (uint16_t j = 0; j < tuner->nb_games; j++)
+                total += tuner->scores[i * tuner->nb_games + j];
+            tuner->fitness[i] = (double) total / tuner->nb_games;
+            mean += tuner->fitness[i] / tuner->population;
+        }
+        sort_candidates(tuner, order);
+
+        timespec_get(&end, TIME_UTC);
+        double seconds = (double) (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+        const AIWeights* best = &tuner->candidates[order[0]];
+        printf("generation %u best %.0f mean %.0f in %.1f s, weights", generation, tuner->fitness[order[0]], mean, seconds);
+        for (uint8_t i = 0; i < NB_FEATURES; i++)
+            printf(" %.3f", best->weights[i]);
+        printf("\n");
+        save_weights(weights_path, best);
+
+        breed_candidates(tuner, order, &rng);
+    }
+
+    clean_thread_pool(&pool);
+    free(tuner);
+    return 0;
+}
+
+
+/**
+ * Callback method called when the board is full, the games check the board instead.
+*/
+void tuner_full_callback()
+{
+}
+
+
+/**
+ * Play a game of a candidate, a task of the thread pool.
+ *
+ * \param context the tuner.
+ * \param task the index of the game, the games of a candidate follow each other.
+ * \param worker the index of the worker running the task, unused.
+*/
+void play_tuner_game(void* context, uint32_t task, uint8_t worker)
+{
+    (void) worker;
+    Tuner* tuner = context;
+    const uint16_t candidate = task / tuner->nb_games;
+    const uint32_t seed = tuner->first_seed + task % tuner->nb_games;
+    tuner->scores[task] = play_game(&tuner->candidates[candidate], seed, tuner->randomizer,
+        tuner->beam_width, tuner->beam_depth);
+}
+
+
+/**
+ * Play a game of the AI until its board is full, only with the calling thread.
+ *
+ * \param weights the weights of the AI.
+ * \param seed the seed of the random generator.
+ * \param randomizer the way the block types are chosen.
+ * \param beam_width the number of boards kept by the lookahead of the AI.
+ * \param beam_depth the number of tetrominos placed by the lookahead of the AI.
+ * \return the score of the game, 0 if it can't be created.
+*/
+uint32_t play_game(const AIWeights* weights, uint32_t seed, Randomizer randomizer, uint8_t beam_width, uint8_t beam_depth)
+{
+    Board* board = create_board(&tuner_full_callback, seed);
+    AI* ai = board != NULL ? create_ai(board) : NULL;
+    if (ai == NULL)
+    {
+        printf("seed %u : error creating the game\n", seed);
+        if (board != NULL)
+            clean_board(&board);
+        return 0;
+    }
+    set_ai_difficulty(ai, EXTREME);
+    set_ai_lookahead(ai, beam_width, beam_depth);
+    set_ai_weights(ai, weights);
+    if (randomizer != RANDOMIZER_UNIFORM)
+    {
+        set_randomizer(board, randomizer);
+        seed_board(board, seed);
+    }
+
+    uint32_t frames = 0;
+    while (!board->full && frames < TUNER_MAX_FRAMES)
+    {
+        update_board(board, TUNER_DELTA_T);
+        ai_process(ai, TUNER_DELTA_T);
+        frames++;
+    }
+    const uint32_t score = board->score;
+
+    clean_ai(&ai);
+    clean_board(&board);
+    return score;
+}
+
+
+/**
+ * Sort the candidates by fitness, the best first. The sort is stable so the results stay deterministic.
+ *
+ * \param tuner the tuner with the fitness of its candidates.
+ * \param order the indexes of the candidates sorted, population values.
+*/
+void sort_candidates(const Tuner* tuner, uint16_t* order)
+{
+    for (uint16_t i = 0; i < tuner->population; i++)
+    {
+        uint16_t j = i;
+        while (j > 0 && tuner->fitness[order[j - 1]] < tuner->fitness[i])
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+}
+
+
+/**
+ * Replace the candidates by the next generation : the best ones are kept and the others are children
+ * of two parents chosen by tournament, blended and mutated.
+ *
+ * \param tuner the tuner with the fitness of its candidates.
+ * \param order the indexes of the candidates sorted, the best first.
+ * \param rng the random generator of the tuner.
+*/
+void breed_candidates(Tuner* tuner, const uint16_t* order, Rng* rng)
+{
+    AIWeights children[TUNER_MAX_POPULATION];
+    for (uint16_t i = 0; i < TUNER_ELITES; i++)
+        children[i] = tuner->candidates[order[i]];
+
+    for (uint16_t i = TUNER_ELITES; i < tuner->population; i++)
+    {
+        const AIWeights* first = &tuner->candidates[select_parent(tuner, rng)];
+        const AIWeights* second = &tuner->candidates[select_parent(tuner, rng)];
+        for (uint8_t j = 0; j < NB_FEATURES; j++)
+        {
+            const float blend = random_uniform(rng);
+            children[i].weights[j] = first->weights[j] + blend * (second->weights[j] - first->weights[j]);
+        }
+        mutate_weights(&children[i], TUNER_MUTATION_RATE, rng);
+    }
+    memcpy(tuner->candidates, children, tuner->population * sizeof(AIWeights));
+}
+
+
+/**
+ * Choose a parent with a tournament, the best of a few random candidates.
+ *
+ * \param tuner the tuner with the fitness of its candidates.
+ * \param rng the random generator of the tuner.
+ * \return the index of the parent.
+*/
+uint16_t select_parent(const Tuner* tuner, Rng* rng)
+{
+    uint16_t best = random_below(rng, tuner->population);
+    for (uint8_t i = 1; i < TUNER_TOURNAMENT; i++)
+    {
+        const uint16_t candidate = random_below(rng, tuner->population);
+        if (tuner->fitness[candidate] > tuner->fitness[best])
+            best = candidate;
+    }
+    return best;
+}
+
+
+/**
+ * Add gaussian noise to some weights, then give them a norm of 1 again.
+ * Only the ratios between the weights change the choices of the AI, the norm is fixed to compare them.
+ *
+ * \param weights the weights mutated.
+ * \param rate the probability of each weight to mutate.
+ * \param rng the random generator of the tuner.
+*/
+void mutate_weights(AIWeights* weights, float rate, Rng* rng)
+{
+    for (uint8_t i = 0; i < NB_FEATURES; i++)
+    {
+        if (random_uniform(rng) < rate)
+            weights->weights[i] += TUNER_MUTATION_SIGMA * random_gaussian(rng);
+    }
+    normalize_weights(weights);
+}
+
+
+/**
+ * Give a norm of 1 to weights, they are unchanged if they are all 0.
+ *
+ * \param weights the weights normalized.
+*/
+void normalize_weights(AIWeights* weights)
+{
+    float norm = 0;
+    for (uint8_t i = 0; i < NB_FEATURES; i++)
+        norm += weights->weights[i] * weights->weights[i];
+    if (norm <= 0)
+        return;
+    norm = sqrtf(norm);
+    for (uint8_t i = 0; i < NB_FEATURES; i++)
+        weights->weights[i] /= norm;
+}
+
+
+/**
+ * Get a random number with a uniform distribution.
+ *
+ * \param rng the random generator.
+ * \return the number, between 0 included and 1 excluded.
+*/
+float random_uniform(Rng* rng)
+{
+    return (next_random(rng) >> 8) / 16777216.0f;
+}
+
+
+/**
+ * Get a random number with a normal distribution (Box-Muller transform).
+ *
+ * \param rng the random generator.
+ * \return the number, with a mean of 0 and a standard deviation of 1.
+*/
+float random_gaussian(Rng* rng)
+{
+    const double radius = sqrt(-2 * log(1 - random_uniform(rng)));
+    return (float) (radius * cos(TUNER_TAU * random_uniform(rng)));
+}
@@ -49,7 +49,7 @@ uint8_t number_of_digits(uint32_t n)
  * 
  * \param map the map to be printed.
 */
-void print_map(uint8_t** map) 
+void print_map(const Map* map) 
 {
     printf("[");
     for(uint8_t i = 0; i < MAP_HEIGHT; i++)
@@ -58,9 +58,9 @@ void print_map(uint8_t** map)
         for(uint8_t j = 0; j < MAP_WIDTH; j++)
         {
             if(j == MAP_WIDTH - 1)
-                printf("%d]", map[i][j]);
+                printf("%d]", map->colors[i][j]);
             else 
-                printf("%d, ", map[i][j]);
+                printf("%d, ", map->colors[i][j]);
         }
         if(i == MAP_HEIGHT - 1)
             printf("]");
@@ -76,33 +76,35 @@ void print_map(uint8_t** map)
  * 
  * \param tetromino the tetromino containing the squares to be printed.
 */
-void print_tetromino(Tetromino* tetromino) 
+void print_tetromino(const Tetromino* tetromino) 
 {
     printf("Tetromino : (%s)[", get_string_for_block_type(tetromino->block_type));
-    for(uint8_t i = 0; i < tetromino->nb_squares; i++)
+    for(uint8_t i = 0; i < NB_SQUARES; i++)
     {
-        if(i == tetromino->nb_squares - 1)
-            printf("[%d, %d](%d)", tetromino->squares[i]->x, tetromino->squares[i]->y, tetromino->squares[i]->alive);
+        Square square = get_tetromino_square(tetromino, i);
+        if(i == NB_SQUARES - 1)
+            printf("[%d, %d]", square.x, square.y);
         else 
-            printf("[%d, %d](%d), ", tetromino->squares[i]->x, tetromino->squares[i]->y, tetromino->squares[i]->alive);
+            printf("[%d, %d], ", square.x, square.y);
     }
     printf("]\n");
 }
 
 
 /**
- * Print correctly all the tetrominos for a certain board.
+ * Print correctly the actual and the next tetrominos of a certain board.
+ * The locked tetrominos are only in the map.
  * 
  * \param board the board containing the tetrominos.
 */
 void print_all_tetrominos(Board* board) 
 {
-    for(uint8_t i = 0; i < board->nb_tetrominos; i++) 
+    if (board->actual_tetromino.block_type != B_NONE)
+        print_tetromino(&board->actual_tetromino);
+    for (uint8_t i = 0; i < QUEUE_SIZE; i++)
     {
-        Tetromino* tetromino = board->tetrominos[i];
-        if (tetromino == NULL)
-            continue;
-        print_tetromino(tetromino);
+        Tetromino next = spawn_tetromino(get_next_block_type(board, i));
+        print_tetromino(&next);
     }
     printf("\n");
 }
@@ -127,24 +129,6 @@ void print_path(AIAction* actions, uint8_t size_action)
 }
 
 
-/**
- * Print correctly the holes of a board.
- * 
- * \param holes the holes to be printed.
-*/
-void print_holes(uint8_t* holes) 
-{
-    printf("Holes : [");
-    for (uint8_t i = 0; i < MAP_HEIGHT; i++)
-    {
-        if (i == MAP_HEIGHT - 1)
-            printf("%d]\n", holes[i]);
-        else
-            printf("%d, ", holes[i]);
-    }
-}
-
-
 /**
  * Return the corresponding string for this action.
  * 
@@ -163,6 +147,10 @@ char* get_string_for_action(AIAction action)
             return "MOVE_RIGHT";
         case HARD_DROP:
             return "HARD_DROP";
+        case SOFT_DROP:
+            return "SOFT_DROP";
+        case HOLD:
+            return "HOLD";
         default:
             return "UNKNOWN";
     }